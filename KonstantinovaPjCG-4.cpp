@@ -1,5 +1,12 @@
 ﻿#include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <memory>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,6 +16,14 @@
 
 #include "headers/shader.h"
 #include "headers/model.h"
+#include "headers/render_queue.h"
+#include "headers/kinematic_chain.h"
+#include "headers/fk_batch.h"
+#include "headers/uniform_block.h"
+#include "headers/offscreen.h"
+#include "headers/image_writer.h"
+#include "headers/profiler.h"
+#include "headers/ring_buffer.h"
 
 // --- Global var for camera ---
 glm::vec3 cameraPos = glm::vec3(-3.6f, 3.0f, 10.4f);
@@ -26,19 +41,81 @@ float sensitivity = 0.1f;
 
 const int screenResolution = 720;
 
-struct ObjectTransform {
-    glm::vec3 position = glm::vec3(0.0f);
-    glm::vec3 rotation = glm::vec3(0.0f);
-    glm::vec3 scale = glm::vec3(1.0f);
-    glm::vec3 pivotPoint = glm::vec3(0.0f);
-
-    struct {
-        float min = -90.0f;
-        float max = 90.0f;
-    } rotationLimit;
+// --- manipulator joints, loaded from resources/models/model.joints ---
+KinematicChain robotChain;
+
+// Key pairs (increase, decrease) assigned to the movable joints in order
+const int jointKeys[][2] = {
+    { GLFW_KEY_Z, GLFW_KEY_X },
+    { GLFW_KEY_C, GLFW_KEY_V },
+    { GLFW_KEY_B, GLFW_KEY_N },
+    { GLFW_KEY_G, GLFW_KEY_H },
+    { GLFW_KEY_J, GLFW_KEY_K },
+    { GLFW_KEY_U, GLFW_KEY_I },
+    { GLFW_KEY_O, GLFW_KEY_P },
 };
 
-std::vector<ObjectTransform> objectTransforms;
+// --- instanced mode ---
+// Number of robots drawn with instancing (--instances N); 0 draws the single interactive robot
+int robotInstanceCount = 0;
+const float robotSpacing = 6.0f;
+
+// --- headless mode ---
+// --headless <poses file> renders every pose into an offscreen framebuffer and writes images
+// named by --output (printf pattern with one %d for the frame, .png or .ppm); no window is shown
+std::string headlessPosesPath;
+std::string headlessOutputPattern = "pose_%05d.png";
+int headlessResolution = 512;
+const size_t readbackDepth = 3;
+
+// Per-frame staging space of the persistently mapped upload ring (three frames are allocated)
+const GLsizeiptr uploadRingFrameSize = 4 * 1024 * 1024;
+
+// --profile <path> dumps per-frame timings on exit (.json or .csv)
+std::string profileOutputPath;
+
+// --residency keep|compact|release: CPU copy of the model geometry kept after upload.
+// Nothing in the viewer reads it back, so it is released by default
+GeometryResidency geometryResidency = RESIDENCY_RELEASE;
+
+// --packed-vertices: 12-byte quantized vertices instead of 24-byte float ones
+VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+
+// --lod-error <pixels>: largest screen-space error a simplified level may show; 0 disables LODs
+float lodPixelError = 1.0f;
+
+// --no-cull: submit every mesh even when it lies outside the view frustum
+bool frustumCulling = true;
+
+// --cpu-cull: cull and pick LODs of instanced robots on the CPU instead of the compute pass
+bool gpuCulling = true;
+
+// --no-occlusion: skip the Hi-Z occlusion phase of GPU culling
+bool occlusionCulling = true;
+
+// The frame number is the only argument, so the pattern may hold exactly one %d-style
+// conversion (flags "0" and "-", a width) and no other directive
+bool validOutputPattern(const std::string& pattern) {
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (pattern[i] != '%')
+            continue;
+        size_t j = i + 1;
+        while (j < pattern.size() && (pattern[j] == '0' || pattern[j] == '-'))
+            j++;
+        while (j < pattern.size() && pattern[j] >= '0' && pattern[j] <= '9')
+            j++;
+        if (j >= pattern.size() || (pattern[j] != 'd' && pattern[j] != 'i'))
+            return false;
+        conversions++;
+        i = j;
+    }
+    return conversions == 1;
+}
+
+std::string shaderDefines() {
+    return vertexFormat == VERTEX_FORMAT_PACKED ? "#define PACKED_VERTICES\n" : "";
+}
 
 void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     float xpos = static_cast<float>(xposIn);
@@ -71,48 +148,6 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     cameraFront = glm::normalize(front);
 }
 
-glm::mat4 calculateModelMatrix(int index) {
-    glm::mat4 model = glm::mat4(1.0f);
-
-    if (index == 0) {
-        return model;
-    }
-
-    if (index == 1) {
-        model = glm::translate(model, objectTransforms[1].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[1].rotation.z), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[1].pivotPoint);
-        return model;
-    }
-
-    if (index == 2) {
-        model = glm::translate(model, objectTransforms[1].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[1].rotation.z), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[1].pivotPoint);
-
-        model = glm::translate(model, objectTransforms[2].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[2].rotation.z), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[2].pivotPoint);
-        return model;
-    }
-
-    if (index == 3) {
-        model = glm::translate(model, objectTransforms[1].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[1].rotation.z), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[1].pivotPoint);
-
-        model = glm::translate(model, objectTransforms[2].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[2].rotation.z), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[2].pivotPoint);
-
-        model = glm::translate(model, objectTransforms[3].pivotPoint);
-        model = glm::rotate(model, glm::radians(objectTransforms[3].rotation.z), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::translate(model, -objectTransforms[3].pivotPoint);
-        return model;
-    }
-    return model;
-}
-
 void processInput(GLFWwindow* window) {
     float currentFrame = glfwGetTime();
     deltaTime = currentFrame - lastFrame;
@@ -137,80 +172,327 @@ void processInput(GLFWwindow* window) {
         cameraPos += cameraRight * cameraSpeed;
 
     // Model rotation controls
-    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) {
-        objectTransforms[1].rotation.z += rotateSpeed;
-        objectTransforms[1].rotation.z = glm::clamp(objectTransforms[1].rotation.z,
-            objectTransforms[1].rotationLimit.min,
-            objectTransforms[1].rotationLimit.max);
+    size_t keyPair = 0;
+    const size_t keyPairCount = sizeof(jointKeys) / sizeof(jointKeys[0]);
+    for (size_t i = 0; i < robotChain.size() && keyPair < keyPairCount; ++i) {
+        if (!robotChain.isMovable(i))
+            continue;
+        if (glfwGetKey(window, jointKeys[keyPair][0]) == GLFW_PRESS)
+            robotChain.setAngle(i, robotChain.joints[i].angle + rotateSpeed);
+        if (glfwGetKey(window, jointKeys[keyPair][1]) == GLFW_PRESS)
+            robotChain.setAngle(i, robotChain.joints[i].angle - rotateSpeed);
+        ++keyPair;
     }
-    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
-        objectTransforms[1].rotation.z -= rotateSpeed;
-        objectTransforms[1].rotation.z = glm::clamp(objectTransforms[1].rotation.z,
-            objectTransforms[1].rotationLimit.min,
-            objectTransforms[1].rotationLimit.max);
+}
+
+// Per-frame uniform blocks shared by every program through fixed binding points
+struct SceneUniforms {
+    UniformBlock<FrameData> frame{ FRAME_DATA_BINDING };
+    UniformBlock<LightData> light{ LIGHT_DATA_BINDING };
+};
+
+void updateSceneUniforms(SceneUniforms& scene, PersistentRingBuffer& ring, const glm::mat4& projection, const glm::mat4& view) {
+    // Матрицы проекции и вида, позиция камеры
+    FrameData frame{};
+    frame.projection = projection;
+    frame.view = view;
+    frame.viewPos = cameraPos;
+    scene.frame.update(frame, &ring);
+
+    // Настройка освещения
+    LightData light{};
+    light.position = glm::vec3(5.0f, 3.0f, 5.0f);
+    light.ambient = glm::vec3(0.3f, 0.3f, 0.3f);
+    light.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+    light.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+    light.intensity = 2.0f;
+    scene.light.update(light, &ring);
+    // Материалы берутся из model.mtl: таблица модели, индекс в записи каждой отрисовки
+}
+
+// Robots are laid out on a square grid; each gets a fixed pose offset so the fleet is not uniform
+void initRobotInstances(std::vector<RobotInstance>& instances, std::vector<float>& poseOffsets, int count) {
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    size_t jointCount = robotChain.size();
+    instances.resize(count);
+    poseOffsets.resize(count * jointCount);
+
+    unsigned int seed = 12345u;
+    auto random01 = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+    };
+
+    for (int i = 0; i < count; ++i) {
+        float x = (i % side - side / 2) * robotSpacing;
+        float z = (i / side - side / 2) * robotSpacing;
+        instances[i].origin = glm::vec4(x, 0.0f, z, 1.0f);
+        for (size_t j = 0; j < jointCount; ++j) {
+            poseOffsets[i * jointCount + j] = (random01() * 2.0f - 1.0f) * 45.0f;
+        }
     }
+}
 
-    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
-        objectTransforms[2].rotation.z += rotateSpeed;
-        objectTransforms[2].rotation.z = glm::clamp(objectTransforms[2].rotation.z,
-            objectTransforms[2].rotationLimit.min,
-            objectTransforms[2].rotationLimit.max);
+// Keyboard-driven angles plus each robot's own offset, clamped to the joint limits
+void updateRobotAngles(std::vector<float>& angles, const std::vector<float>& poseOffsets) {
+    size_t jointCount = robotChain.size();
+    angles.resize(poseOffsets.size());
+    for (size_t k = 0; k < poseOffsets.size(); ++k) {
+        const Joint& joint = robotChain.joints[k % jointCount];
+        angles[k] = glm::radians(glm::clamp(joint.angle + poseOffsets[k], joint.minAngle, joint.maxAngle));
     }
-    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS) {
-        objectTransforms[2].rotation.z -= rotateSpeed;
-        objectTransforms[2].rotation.z = glm::clamp(objectTransforms[2].rotation.z,
-            objectTransforms[2].rotationLimit.min,
-            objectTransforms[2].rotationLimit.max);
+}
+
+// Everything the render loop needs once the GL context exists
+struct Scene {
+    Shader modelShader{ "shaders/shader.vert", "shaders/shader.frag", shaderDefines() };
+    Shader instancedShader{ "shaders/instanced.vert", "shaders/shader.frag", shaderDefines() };
+    SceneUniforms uniforms;
+    PersistentRingBuffer uploadRing;
+    Model model{ "resources/models/model.obj", geometryResidency, vertexFormat };
+
+    RobotInstanceBuffer robotInstances;
+    std::vector<RobotInstance> instanceOrigins;
+    std::vector<float> instancePoseOffsets;
+    std::vector<float> instanceAngles;
+
+    // Culling and draw list built on the GPU (instanced mode without --cpu-cull)
+    std::unique_ptr<GpuCuller> gpuCuller;
+
+    // Poses of every robot on the CPU, only for CPU culling: angles transposed to joint-major order
+    // and the resulting part matrices
+    std::unique_ptr<BatchFK> instanceFK;
+    std::vector<float> instanceAnglesSoA;
+    std::vector<glm::mat4> instancePartTransforms;
+
+    RenderQueue renderQueue;
+};
+
+// false when the joint hierarchy cannot be loaded; the robot cannot be posed without it
+bool initScene(Scene& scene) {
+    scene.uploadRing.create(uploadRingFrameSize);
+
+    // Иерархия шарниров манипулятора
+    if (!robotChain.load("resources/models/model.joints"))
+        return false;
+    for (size_t i = 0; i < robotChain.size(); ++i) {
+        scene.model.UpdateTransform(i, robotChain.worldTransforms[i]);
     }
 
-    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS) {
-        objectTransforms[3].rotation.z += rotateSpeed;
-        objectTransforms[3].rotation.z = glm::clamp(objectTransforms[3].rotation.z,
-            objectTransforms[3].rotationLimit.min,
-            objectTransforms[3].rotationLimit.max);
+    // Инстансинг: общая таблица шарниров и состояние каждого робота
+    if (robotInstanceCount > 0) {
+        scene.robotInstances.setJoints(robotChain);
+        initRobotInstances(scene.instanceOrigins, scene.instancePoseOffsets, robotInstanceCount);
+        scene.robotInstances.setInstances(scene.instanceOrigins);
+        if (gpuCulling)
+            scene.gpuCuller = std::make_unique<GpuCuller>(scene.model.meshes, occlusionCulling);
+        else
+            scene.instanceFK = std::make_unique<BatchFK>(robotChain);
     }
-    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS) {
-        objectTransforms[3].rotation.z -= rotateSpeed;
-        objectTransforms[3].rotation.z = glm::clamp(objectTransforms[3].rotation.z,
-            objectTransforms[3].rotationLimit.min,
-            objectTransforms[3].rotationLimit.max);
+    return true;
+}
+
+// Pose bounds of every robot for culling: the same chain the vertex shader walks, evaluated
+// in SIMD batches
+void updateInstanceBounds(Scene& scene) {
+    size_t jointCount = robotChain.size();
+    size_t count = scene.instanceOrigins.size();
+    scene.instanceAnglesSoA.resize(scene.instanceAngles.size());
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < jointCount; ++j) {
+            scene.instanceAnglesSoA[j * count + i] = scene.instanceAngles[i * jointCount + j];
+        }
     }
+    scene.instancePartTransforms.resize(count * jointCount);
+    scene.instanceFK->evaluate(scene.instanceAnglesSoA.data(), count, count, scene.instancePartTransforms.data());
+    scene.model.SetInstanceBounds(scene.robotInstances, scene.instancePartTransforms.data(),
+        scene.instanceFK->jointCount());
 }
 
-void drawModel(Shader& shader, Model& modelObj, glm::mat4 projection, glm::mat4 view) {
-    shader.use();
+void renderScene(Scene& scene, FrameProfiler& profiler, int width, int height) {
+    // Настройка матриц проекции и вида
+    float farPlane = robotInstanceCount > 0 ? 1000.0f : 100.0f;
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.0f),
+        (float)width / (float)height,
+        0.1f,
+        farPlane
+    );
+    glm::mat4 view = glm::lookAt(
+        cameraPos,
+        cameraPos + cameraFront,
+        cameraUp
+    );
+
+    // Пересчитываем только шарниры, чьи углы изменились: звено i движется вместе с шарниром i
+    profiler.beginStage(FrameProfiler::STAGE_TRANSFORMS);
+    bool poseChanged = robotChain.evaluate() > 0;
+    bool anglesChanged = false;
+    if (robotInstanceCount > 0) {
+        if (poseChanged || scene.instanceAngles.empty()) {
+            updateRobotAngles(scene.instanceAngles, scene.instancePoseOffsets);
+            if (scene.instanceFK)
+                updateInstanceBounds(scene);
+            anglesChanged = true;
+        }
+    }
+    else {
+        for (size_t i : robotChain.changedJoints) {
+            scene.model.UpdateTransform(i, robotChain.worldTransforms[i]);
+        }
+    }
+    // Уровни детализации выбираются по экранной ошибке для текущей камеры
+    LodView lodView = LodView::fromProjection(projection, cameraPos, height, lodPixelError);
+    // Меши вне пирамиды видимости не попадают в список отрисовки
+    Frustum frustum = frustumCulling ? Frustum::fromMatrix(projection * view) : Frustum();
+    scene.model.SetLodView(lodView);
+    scene.model.SetFrustum(frustum);
+    profiler.endStage(FrameProfiler::STAGE_TRANSFORMS);
+
+    // Загрузка uniform-блоков и трансформаций на GPU через кольцевой буфер
+    profiler.beginStage(FrameProfiler::STAGE_UPLOAD);
+    scene.uploadRing.beginFrame();
+    updateSceneUniforms(scene.uniforms, scene.uploadRing, projection, view);
+    if (anglesChanged)
+        scene.robotInstances.setAngles(scene.instanceAngles, &scene.uploadRing);
+    if (robotInstanceCount == 0)
+        scene.model.UploadTransforms(&scene.uploadRing);
+    // При отсечении на GPU список отрисовки строит вычислительный шейдер, CPU передаёт только углы
+    if (scene.gpuCuller)
+        scene.gpuCuller->setView(frustum, lodView, projection * view, width, height,
+            scene.robotInstances.instanceCount, &scene.uploadRing);
+    else
+        scene.model.PrepareDraws(robotInstanceCount > 0 ? &scene.robotInstances : nullptr, &scene.uploadRing);
+    profiler.endStage(FrameProfiler::STAGE_UPLOAD);
+
+    // Очистка экрана и рендеринг модели
+    profiler.beginStage(FrameProfiler::STAGE_DRAW);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Отрисовки выполняются в порядке ключа (программа, VAO, материал, глубина),
+    // повторные привязки того же состояния отбрасывает GLStateCache
+    scene.renderQueue.setView(cameraPos, farPlane);
+    if (scene.gpuCuller)
+        scene.renderQueue.submitCulled(scene.model, scene.instancedShader, scene.robotInstances, *scene.gpuCuller);
+    else if (robotInstanceCount > 0)
+        scene.renderQueue.submitInstanced(scene.model, scene.instancedShader, scene.robotInstances);
+    else
+        scene.renderQueue.submit(scene.model, scene.modelShader);
+    scene.renderQueue.flush();
+    scene.uploadRing.endFrame();
+    profiler.endStage(FrameProfiler::STAGE_DRAW);
+}
 
-    // Настройка материалов
-    shader.setVec3("material.ambient", 0.24725f, 0.1995f, 0.0745f);
-    shader.setVec3("material.diffuse", 0.75164f, 0.60648f, 0.22648f);
-    shader.setVec3("material.specular", 0.628281f, 0.555802f, 0.366065f);
-    shader.setFloat("material.shininess", 51.2f);
+// One pose per line: camX camY camZ targetX targetY targetZ followed by joint angles in degrees
+bool applyPose(const std::string& line) {
+    std::istringstream in(line);
+    glm::vec3 target;
+    if (!(in >> cameraPos.x >> cameraPos.y >> cameraPos.z >> target.x >> target.y >> target.z))
+        return false;
+    cameraFront = glm::normalize(target - cameraPos);
+
+    float angle;
+    for (size_t i = 0; i < robotChain.size() && (in >> angle); ++i) {
+        robotChain.setAngle(i, angle);
+    }
+    return true;
+}
 
-    // Настройка освещения
-    glm::vec3 lightPos = glm::vec3(5.0f, 3.0f, 5.0f);
-    shader.setVec3("light.position", lightPos);
-    shader.setVec3("light.ambient", 0.3f, 0.3f, 0.3f);
-    shader.setVec3("light.diffuse", 1.0f, 1.0f, 1.0f);
-    shader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-    shader.setFloat("light.intensity", 2.0f);
-
-    // Позиция камеры
-    shader.setVec3("viewPos", cameraPos);
-
-    // Матрицы проекции и вида
-    shader.setMat4("projection", projection);
-    shader.setMat4("view", view);
-
-    // Обновляем трансформации для всех мешей
-    for (size_t i = 0; i < modelObj.meshTransforms.size(); ++i) {
-        modelObj.meshTransforms[i] = calculateModelMatrix(i);
+int runHeadless(Scene& scene, FrameProfiler& profiler) {
+    std::ifstream poses(headlessPosesPath);
+    if (!poses) {
+        fprintf(stderr, "ERROR: could not open pose file %s\n", headlessPosesPath.c_str());
+        return 1;
     }
 
-    // Рендерим модель с уже обновленными трансформациями
-    modelObj.Draw(shader);
+    OffscreenTarget target;
+    if (!target.create(headlessResolution, headlessResolution))
+        return 1;
+
+    size_t written = 0;
+    AsyncReadback readback;
+    readback.create(target.width, target.height, readbackDepth,
+        [&written](size_t tag, const unsigned char* rgb, int width, int height) {
+            char path[1024];
+            snprintf(path, sizeof(path), headlessOutputPattern.c_str(), static_cast<int>(tag));
+            if (ImageWriter::write(path, rgb, width, height))
+                ++written;
+        });
+
+    target.bind();
+    auto start = std::chrono::steady_clock::now();
+    size_t frame = 0;
+    std::string line;
+    while (std::getline(poses, line)) {
+        if (line.empty() || line[0] == '#' || !applyPose(line))
+            continue;
+
+        profiler.beginFrame();
+        renderScene(scene, profiler, target.width, target.height);
+        readback.request(frame++);
+        readback.poll();
+        profiler.endFrame();
+    }
+    readback.finish();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Rendered %zu poses, wrote %zu images in %.3f s (%.1f fps)\n",
+        frame, written, seconds, seconds > 0.0 ? frame / seconds : 0.0);
+    const GLStateCache::Stats& glState = GLStateCache::current().statistics();
+    printf("GL state: %zu binds issued, %zu redundant binds skipped\n", glState.issued, glState.skipped);
+    return written == frame ? 0 : 1;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            robotInstanceCount = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            headlessPosesPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            headlessOutputPattern = argv[++i];
+            if (!validOutputPattern(headlessOutputPattern)) {
+                fprintf(stderr, "ERROR: --output needs exactly one %%d frame number conversion: %s\n",
+                    headlessOutputPattern.c_str());
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            headlessResolution = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profileOutputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lod-error") == 0 && i + 1 < argc) {
+            lodPixelError = std::max(0.0f, static_cast<float>(std::atof(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--cpu-cull") == 0) {
+            gpuCulling = false;
+        }
+        else if (std::strcmp(argv[i], "--no-occlusion") == 0) {
+            occlusionCulling = false;
+        }
+        else if (std::strcmp(argv[i], "--no-cull") == 0) {
+            frustumCulling = false;
+        }
+        else if (std::strcmp(argv[i], "--packed-vertices") == 0) {
+            vertexFormat = VERTEX_FORMAT_PACKED;
+        }
+        else if (std::strcmp(argv[i], "--residency") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "keep") == 0)
+                geometryResidency = RESIDENCY_KEEP;
+            else if (std::strcmp(mode, "compact") == 0)
+                geometryResidency = RESIDENCY_COMPACT;
+            else
+                geometryResidency = RESIDENCY_RELEASE;
+        }
+    }
+    bool headless = !headlessPosesPath.empty();
+
     if (!glfwInit()) {
         fprintf(stderr, "ERROR: could not start GLFW3.\n");
         return 1;
@@ -220,6 +502,8 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // В headless-режиме окно только держит контекст, рисуем во фреймбуфер
+    glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
 
     GLFWwindow* window = glfwCreateWindow(screenResolution, screenResolution, "Main window", NULL, NULL);
     if (!window) {
@@ -236,54 +520,56 @@ int main() {
 
     glEnable(GL_DEPTH_TEST);
 
-    // Загружаем шейдер
-    Shader modelShader("shaders/shader.vert", "shaders/shader.frag");
-
-    // Загружаем модель
-    Model modelObj("resources/models/model.obj");
-
-    // Инициализация трансформаций
-    objectTransforms.resize(4);
-    objectTransforms[1].pivotPoint = glm::vec3(1.8f, 0.0f, 1.7f);
-    objectTransforms[2].pivotPoint = glm::vec3(0.0f, 1.9f, 2.55f);
-    objectTransforms[3].pivotPoint = glm::vec3(0.0f, 3.746f, 2.545f);
-
-    objectTransforms[1].rotationLimit = { -90.0f, 90.0f };
-    objectTransforms[2].rotationLimit = { -25.0f, 60.0f };
-    objectTransforms[3].rotationLimit = { -90.0f, 90.0f };
-
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    // Главный цикл рендеринга
-    while (!glfwWindowShouldClose(window)) {
-        processInput(window);
-
-        // Очистка экрана
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Настройка матриц проекции и вида
-        glm::mat4 projection = glm::perspective(
-            glm::radians(45.0f),
-            (float)screenResolution / (float)screenResolution,
-            0.1f,
-            100.0f
-        );
-        glm::mat4 view = glm::lookAt(
-            cameraPos,
-            cameraPos + cameraFront,
-            cameraUp
-        );
-
-        // Рендеринг модели
-        drawModel(modelShader, modelObj, projection, view);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    int exitCode = 0;
+    {
+        // Загружаем шейдеры и модель
+        Scene scene;
+        FrameProfiler profiler;
+        bool loaded = initScene(scene);
+
+        if (!loaded) {
+            exitCode = 1;
+        }
+        else if (headless) {
+            exitCode = runHeadless(scene, profiler);
+        }
+        else {
+            glfwSetCursorPosCallback(window, mouse_callback);
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+            // Главный цикл рендеринга
+            double lastOverlay = glfwGetTime();
+            while (!glfwWindowShouldClose(window)) {
+                profiler.beginFrame();
+
+                profiler.beginStage(FrameProfiler::STAGE_INPUT);
+                processInput(window);
+                profiler.endStage(FrameProfiler::STAGE_INPUT);
+
+                renderScene(scene, profiler, screenResolution, screenResolution);
+
+                profiler.beginStage(FrameProfiler::STAGE_SWAP);
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                profiler.endStage(FrameProfiler::STAGE_SWAP);
+
+                profiler.endFrame();
+
+                // Оверлей: перцентили времени кадра в заголовке окна
+                if (glfwGetTime() - lastOverlay > 0.5) {
+                    lastOverlay = glfwGetTime();
+                    glfwSetWindowTitle(window, ("Main window | " + profiler.overlay()).c_str());
+                }
+            }
+        }
+
+        if (loaded && !profileOutputPath.empty()) {
+            glFinish();
+            profiler.dump(profileOutputPath);
+        }
     }
 
     glfwDestroyWindow(window);
     glfwTerminate();
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#define BENCH_CHDIR _chdir
+#else
+#include <unistd.h>
+#define BENCH_CHDIR chdir
+#endif
+
+// Shared helpers for the benchmark executables built by CMakeLists.txt
+namespace Bench {
+
+    inline double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct Stats {
+        double min = 0.0, p50 = 0.0, p99 = 0.0, mean = 0.0;
+    };
+
+    inline Stats summarize(std::vector<double> samples) {
+        Stats stats;
+        if (samples.empty())
+            return stats;
+        std::sort(samples.begin(), samples.end());
+        auto at = [&samples](double q) {
+            size_t index = static_cast<size_t>(q * (samples.size() - 1) + 0.5);
+            return samples[std::min(index, samples.size() - 1)];
+        };
+        stats.min = samples.front();
+        stats.p50 = at(0.50);
+        stats.p99 = at(0.99);
+        double sum = 0.0;
+        for (double s : samples) sum += s;
+        stats.mean = sum / samples.size();
+        return stats;
+    }
+
+    // Samples are in seconds, printed in milliseconds
+    inline void report(const char* name, const std::vector<double>& samples) {
+        Stats s = summarize(samples);
+        std::printf("%-40s min %9.3f ms  p50 %9.3f ms  p99 %9.3f ms  mean %9.3f ms  (%zu runs)\n",
+            name, s.min * 1e3, s.p50 * 1e3, s.p99 * 1e3, s.mean * 1e3, samples.size());
+    }
+
+    // Benchmarks load shaders/ and resources/ relative to the repository root
+    inline void enterSourceDir() {
+#ifdef CG4_SOURCE_DIR
+        if (BENCH_CHDIR(CG4_SOURCE_DIR) != 0)
+            std::fprintf(stderr, "WARNING: could not enter %s\n", CG4_SOURCE_DIR);
+#endif
+    }
+
+    inline int intArg(int argc, char** argv, const char* name, int fallback) {
+        for (int i = 1; i + 1 < argc; i++) {
+            if (std::string(argv[i]) == name)
+                return std::atoi(argv[i + 1]);
+        }
+        return fallback;
+    }
+}
+
+#ifdef BENCH_WITH_GL
+#include <glad/glad.h>
+#include <glfw3.h>
+
+namespace Bench {
+
+    // Hidden window that only provides a GL 4.6 core context
+    inline GLFWwindow* createHiddenContext() {
+        if (!glfwInit()) {
+            std::fprintf(stderr, "ERROR: could not start GLFW3.\n");
+            return nullptr;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow* window = glfwCreateWindow(64, 64, "bench", NULL, NULL);
+        if (!window) {
+            glfwTerminate();
+            return nullptr;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0);
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::fprintf(stderr, "Failed to initialize GLAD\n");
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return nullptr;
+        }
+        return window;
+    }
+
+    inline void destroyContext(GLFWwindow* window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "bench/bench_common.h"
+#include "headers/frustum.h"
+
+// Frustum culling throughput of SphereCuller on every available kernel. Spheres are scattered
+// over a robot-fleet-sized grid seen from above at an angle, so most of them are culled
+int main(int argc, char** argv) {
+    int runs = Bench::intArg(argc, argv, "--runs", 20);
+
+    SphereCuller culler;
+    std::printf("detected kernel: %s\n", simdPathName(culler.path));
+
+    std::vector<SimdPath> paths = { SimdPath::Scalar };
+    if (culler.path == SimdPath::SSE2 || culler.path == SimdPath::AVX2)
+        paths.push_back(SimdPath::SSE2);
+    if (culler.path == SimdPath::AVX2)
+        paths.push_back(SimdPath::AVX2);
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(-40.0f, 60.0f, -40.0f), glm::vec3(60.0f, 0.0f, 60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    for (size_t count : { size_t(10000), size_t(100000), size_t(1000000) }) {
+        SphereSet spheres;
+        spheres.resize(count);
+        unsigned int seed = 1u;
+        auto random01 = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+        for (size_t k = 0; k < count; k++) {
+            glm::vec3 center(random01() * 600.0f - 300.0f, random01() * 4.0f, random01() * 600.0f - 300.0f);
+            spheres.set(k, center, 0.2f + random01());
+        }
+
+        std::vector<uint8_t> reference(count), visible(count);
+        culler.path = SimdPath::Scalar;
+        culler.cull(frustum, spheres, 0, count, reference.data());
+
+        for (SimdPath path : paths) {
+            culler.path = path;
+            std::vector<double> samples;
+            size_t visibleCount = 0;
+            for (int r = 0; r < runs; r++) {
+                double start = Bench::now();
+                visibleCount = culler.cull(frustum, spheres, 0, count, visible.data());
+                samples.push_back(Bench::now() - start);
+            }
+            // FMA rounding may flip a sphere that touches a plane, anything more is a kernel bug
+            size_t mismatches = 0;
+            for (size_t k = 0; k < count; k++)
+                mismatches += visible[k] != reference[k] ? 1 : 0;
+            if (mismatches > count / 10000) {
+                std::fprintf(stderr, "ERROR: %s kernel disagrees with the scalar one on %zu spheres\n",
+                    simdPathName(path), mismatches);
+                return 1;
+            }
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "cull %s x%zu", simdPathName(path), count);
+            Bench::report(name, samples);
+            double best = Bench::summarize(samples).min;
+            std::printf("%-40s %.1f M spheres/s, %zu visible\n", "", best > 0.0 ? count / best * 1e-6 : 0.0, visibleCount);
+        }
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#define BENCH_WITH_GL
+#include <cstdio>
+#include <vector>
+
+#include "bench/bench_common.h"
+#include "headers/shader.h"
+#include "headers/model.h"
+#include "headers/uniform_block.h"
+#include "headers/kinematic_chain.h"
+#include "headers/offscreen.h"
+
+// CPU cost of submitting one frame: the single robot through Model::Draw and a fleet through
+// Model::DrawInstanced and Model::DrawCulled (compute culling). GPU completion is excluded; glFinish between frames keeps queues short.
+int main(int argc, char** argv) {
+    Bench::enterSourceDir();
+    int frames = Bench::intArg(argc, argv, "--frames", 500);
+    int instances = Bench::intArg(argc, argv, "--instances", 1000);
+
+    GLFWwindow* window = Bench::createHiddenContext();
+    if (!window)
+        return 1;
+    {
+        OffscreenTarget target;
+        target.create(256, 256);
+        target.bind();
+        glEnable(GL_DEPTH_TEST);
+
+        Shader modelShader("shaders/shader.vert", "shaders/shader.frag");
+        Shader instancedShader("shaders/instanced.vert", "shaders/shader.frag");
+        UniformBlock<FrameData> frame(FRAME_DATA_BINDING);
+        UniformBlock<LightData> light(LIGHT_DATA_BINDING);
+        FrameData frameData{};
+        frameData.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+        frameData.view = glm::lookAt(glm::vec3(0.0f, 40.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        frame.update(frameData);
+        light.update(LightData{});
+
+        Model model("resources/models/model.obj");
+        KinematicChain chain;
+        chain.load("resources/models/model.joints");
+
+        RobotInstanceBuffer fleet;
+        fleet.setJoints(chain);
+        std::vector<RobotInstance> origins(instances);
+        for (int i = 0; i < instances; i++) {
+            origins[i].origin = glm::vec4((i % 32) * 6.0f, 0.0f, (i / 32) * 6.0f, 1.0f);
+        }
+        fleet.setInstances(origins);
+        std::vector<float> angles(static_cast<size_t>(instances) * chain.size(), 0.0f);
+        fleet.setAngles(angles);
+
+        GpuCuller culler(model.meshes);
+        glm::mat4 viewProjection = frameData.projection * frameData.view;
+        culler.setView(Frustum::fromMatrix(viewProjection), LodView(), viewProjection, target.width, target.height,
+            fleet.instanceCount);
+
+        std::vector<double> single, instanced, culled;
+        for (int f = 0; f < frames; f++) {
+            // Move one joint every frame so transform upload is part of the measured work
+            chain.setAngle(1, (f % 90) - 45.0f);
+            chain.evaluate();
+            for (size_t i : chain.changedJoints) {
+                model.UpdateTransform(i, chain.worldTransforms[i]);
+            }
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            double start = Bench::now();
+            model.Draw(modelShader);
+            single.push_back(Bench::now() - start);
+            glFinish();
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            start = Bench::now();
+            model.DrawInstanced(instancedShader, fleet);
+            instanced.push_back(Bench::now() - start);
+            glFinish();
+
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            start = Bench::now();
+            model.DrawCulled(instancedShader, fleet, culler);
+            culled.push_back(Bench::now() - start);
+            glFinish();
+        }
+
+        Bench::report("submit single robot", single);
+        char name[64];
+        std::snprintf(name, sizeof(name), "submit %d instanced robots", instances);
+        Bench::report(name, instanced);
+        std::snprintf(name, sizeof(name), "submit %d gpu-culled robots", instances);
+        Bench::report(name, culled);
+    }
+    Bench::destroyContext(window);
+    return 0;
+}
\ No newline at end of file
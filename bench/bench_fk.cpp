@@ -0,0 +1,83 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "bench/bench_common.h"
+#include "headers/fk_batch.h"
+
+// Batch forward-kinematics throughput for the model's joint chain on every available kernel
+int main(int argc, char** argv) {
+    Bench::enterSourceDir();
+    int runs = Bench::intArg(argc, argv, "--runs", 20);
+
+    KinematicChain chain;
+    if (!chain.load("resources/models/model.joints"))
+        return 1;
+
+    BatchFK fk(chain);
+    const size_t jointCount = fk.jointCount();
+    std::printf("joints: %zu, detected kernel: %s\n", jointCount, BatchFK::pathName(fk.path));
+
+    std::vector<BatchFK::Path> paths = { BatchFK::Path::Scalar };
+    if (fk.path == BatchFK::Path::SSE2 || fk.path == BatchFK::Path::AVX2)
+        paths.push_back(BatchFK::Path::SSE2);
+    if (fk.path == BatchFK::Path::AVX2)
+        paths.push_back(BatchFK::Path::AVX2);
+
+    for (size_t instances : { size_t(1000), size_t(10000), size_t(100000) }) {
+        std::vector<float> angles(jointCount * instances);
+        unsigned int seed = 1u;
+        for (float& a : angles) {
+            seed = seed * 1664525u + 1013904223u;
+            a = (static_cast<float>(seed >> 8) / static_cast<float>(1u << 24) * 2.0f - 1.0f) * 1.5f;
+        }
+        std::vector<glm::mat4> out(jointCount * instances);
+
+        // Reference world matrices from KinematicChain, its joint limits opened to the random angles
+        std::vector<glm::mat4> reference(jointCount * instances);
+        KinematicChain unlimited = chain;
+        for (Joint& joint : unlimited.joints) {
+            joint.minAngle = -180.0f;
+            joint.maxAngle = 180.0f;
+        }
+        for (size_t i = 0; i < instances; i++) {
+            for (size_t j = 0; j < jointCount; j++)
+                unlimited.setAngle(j, glm::degrees(angles[j * instances + i]));
+            unlimited.evaluate();
+            std::copy(unlimited.worldTransforms.begin(), unlimited.worldTransforms.end(), reference.begin() + i * jointCount);
+        }
+
+        for (BatchFK::Path path : paths) {
+            fk.path = path;
+            std::vector<double> samples;
+            for (int r = 0; r < runs; r++) {
+                double start = Bench::now();
+                fk.evaluate(angles.data(), instances, instances, out.data());
+                samples.push_back(Bench::now() - start);
+            }
+            float maxError = 0.0f;
+            for (size_t m = 0; m < out.size(); m++) {
+                for (int c = 0; c < 4; c++) {
+                    for (int r = 0; r < 4; r++)
+                        maxError = std::max(maxError, std::fabs(out[m][c][r] - reference[m][c][r]));
+                }
+            }
+            // The kernels use polynomial sin/cos, anything beyond their rounding is a kernel bug
+            if (!(maxError <= 1e-4f)) {
+                std::fprintf(stderr, "ERROR: %s kernel differs from KinematicChain by up to %g\n",
+                    BatchFK::pathName(path), maxError);
+                return 1;
+            }
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "fk %s x%zu", BatchFK::pathName(path), instances);
+            Bench::report(name, samples);
+            double best = Bench::summarize(samples).min;
+            std::printf("%-40s %.1f M links/s, max error %.2g\n", "",
+                best > 0.0 ? instances * jointCount / best * 1e-6 : 0.0, maxError);
+        }
+    }
+    return 0;
+}
\ No newline at end of file
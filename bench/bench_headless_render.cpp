@@ -0,0 +1,94 @@
+#define BENCH_WITH_GL
+#include <cstdio>
+#include <vector>
+
+#include "bench/bench_common.h"
+#include "headers/shader.h"
+#include "headers/model.h"
+#include "headers/uniform_block.h"
+#include "headers/kinematic_chain.h"
+#include "headers/offscreen.h"
+
+// End-to-end offscreen frame rate: random poses rendered into an FBO with asynchronous PBO
+// readback, as in the viewer's --headless mode but without writing image files
+int main(int argc, char** argv) {
+    Bench::enterSourceDir();
+    int frames = Bench::intArg(argc, argv, "--frames", 1000);
+    int size = Bench::intArg(argc, argv, "--size", 512);
+    // --packed 1 renders with 12-byte PackedVertex instead of the 24-byte float layout
+    bool packed = Bench::intArg(argc, argv, "--packed", 0) != 0;
+
+    GLFWwindow* window = Bench::createHiddenContext();
+    if (!window)
+        return 1;
+    {
+        OffscreenTarget target;
+        if (!target.create(size, size))
+            return 1;
+        target.bind();
+        glEnable(GL_DEPTH_TEST);
+
+        Shader modelShader("shaders/shader.vert", "shaders/shader.frag", packed ? "#define PACKED_VERTICES\n" : "");
+        UniformBlock<FrameData> frame(FRAME_DATA_BINDING);
+        UniformBlock<LightData> light(LIGHT_DATA_BINDING);
+        LightData lightData{};
+        lightData.position = glm::vec3(5.0f, 3.0f, 5.0f);
+        lightData.ambient = glm::vec3(0.3f);
+        lightData.diffuse = glm::vec3(1.0f);
+        lightData.specular = glm::vec3(1.0f);
+        lightData.intensity = 2.0f;
+        light.update(lightData);
+
+        Model model("resources/models/model.obj", RESIDENCY_RELEASE,
+            packed ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_FLOAT);
+        KinematicChain chain;
+        chain.load("resources/models/model.joints");
+
+        size_t delivered = 0;
+        AsyncReadback readback;
+        readback.create(size, size, 3, [&delivered](size_t, const unsigned char*, int, int) { ++delivered; });
+
+        unsigned int seed = 7u;
+        auto random01 = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+
+        std::vector<double> samples;
+        double begin = Bench::now();
+        for (int f = 0; f < frames; f++) {
+            double start = Bench::now();
+
+            float orbit = random01() * 6.2831853f;
+            FrameData frameData{};
+            frameData.viewPos = glm::vec3(10.0f * std::cos(orbit), 4.0f + 4.0f * random01(), 10.0f * std::sin(orbit));
+            frameData.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+            frameData.view = glm::lookAt(frameData.viewPos, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            frame.update(frameData);
+
+            for (size_t j = 0; j < chain.size(); j++) {
+                const Joint& joint = chain.joints[j];
+                chain.setAngle(j, joint.minAngle + random01() * (joint.maxAngle - joint.minAngle));
+            }
+            chain.evaluate();
+            for (size_t i : chain.changedJoints) {
+                model.UpdateTransform(i, chain.worldTransforms[i]);
+            }
+
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            model.Draw(modelShader);
+            readback.request(static_cast<size_t>(f));
+            readback.poll();
+
+            samples.push_back(Bench::now() - start);
+        }
+        readback.finish();
+        double total = Bench::now() - begin;
+
+        Bench::report(packed ? "headless frame (cpu, packed vertices)" : "headless frame (cpu)", samples);
+        std::printf("%d frames, %zu read back in %.3f s: %.1f fps\n", frames, delivered, total, total > 0.0 ? frames / total : 0.0);
+    }
+    Bench::destroyContext(window);
+    return 0;
+}
\ No newline at end of file
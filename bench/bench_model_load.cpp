@@ -0,0 +1,82 @@
+#define BENCH_WITH_GL
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "bench/bench_common.h"
+#include "headers/model.h"
+
+// Cold start (Assimp import + cache write) against warm start (mapped mesh cache) for model.obj,
+// then the system memory each GeometryResidency policy leaves behind
+int main(int argc, char** argv) {
+    Bench::enterSourceDir();
+    int runs = Bench::intArg(argc, argv, "--runs", 10);
+
+    GLFWwindow* window = Bench::createHiddenContext();
+    if (!window)
+        return 1;
+
+    // Work on a private copy so the cache next to the real model is left alone
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "cg4_bench_model_load";
+    fs::create_directories(dir);
+    fs::copy_file("resources/models/model.obj", dir / "model.obj", fs::copy_options::overwrite_existing);
+    fs::copy_file("resources/models/model.mtl", dir / "model.mtl", fs::copy_options::overwrite_existing);
+    std::string modelPath = (dir / "model.obj").generic_string();
+    std::string cachePath = modelPath + ".meshcache";
+
+    std::vector<double> cold, warm;
+    MeshOptimizer::Stats importStats;
+    for (int r = 0; r < runs; r++) {
+        fs::remove(cachePath);
+        double start = Bench::now();
+        {
+            Model model(modelPath);
+            glFinish();
+            importStats = model.importStats;
+        }
+        cold.push_back(Bench::now() - start);
+
+        start = Bench::now();
+        {
+            Model model(modelPath);
+            glFinish();
+        }
+        warm.push_back(Bench::now() - start);
+    }
+
+    Bench::report("model load cold (assimp)", cold);
+    Bench::report("model load warm (mesh cache)", warm);
+
+    printf("import ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, vertices %zu -> %zu\n",
+        importStats.before.acmr, importStats.after.acmr, importStats.before.atvr, importStats.after.atvr,
+        importStats.verticesBefore, importStats.verticesAfter);
+    {
+        Model model(modelPath);
+        size_t lodTriangles[kMaxMeshLods] = {};
+        for (const Mesh& mesh : model.meshes)
+            for (size_t l = 0; l < mesh.lods.size(); l++)
+                lodTriangles[l] += mesh.lods[l].indexCount / 3;
+        printf("LOD triangles:");
+        for (size_t l = 0; l < kMaxMeshLods && lodTriangles[l]; l++)
+            printf(" %zu", lodTriangles[l]);
+        printf("\n");
+    }
+
+    const char* names[] = { "keep", "compact", "release" };
+    for (int policy = RESIDENCY_KEEP; policy <= RESIDENCY_RELEASE; policy++) {
+        Model model(modelPath, static_cast<GeometryResidency>(policy));
+        printf("residency %-8s %10zu bytes CPU geometry\n", names[policy], model.CpuGeometryBytes());
+    }
+    {
+        Model model(modelPath, RESIDENCY_RELEASE);
+        double start = Bench::now();
+        model.Rehydrate();
+        printf("rehydrate from mesh cache: %.3f ms, %zu bytes\n",
+            (Bench::now() - start) * 1000.0, model.CpuGeometryBytes());
+    }
+
+    fs::remove_all(dir);
+    Bench::destroyContext(window);
+    return 0;
+}
\ No newline at end of file
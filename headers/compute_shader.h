@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "gl_state.h"
+
+// Single-stage compute program; the source goes through ShaderSource::load like a Shader stage
+class ComputeShader
+{
+public:
+    unsigned int ID = 0;
+
+    explicit ComputeShader(const char* computePath, const std::string& defines = "") {
+        std::string computeCode = ShaderSource::load(computePath, defines);
+        unsigned int compute = ShaderSource::compile(GL_COMPUTE_SHADER, computeCode, "COMPUTE");
+
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        glLinkProgram(ID);
+        ShaderSource::checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+    }
+
+    ComputeShader(const ComputeShader&) = delete;
+    ComputeShader& operator=(const ComputeShader&) = delete;
+
+    ~ComputeShader() {
+        if (ID) {
+            GLStateCache::current().forgetProgram(ID);
+            glDeleteProgram(ID);
+        }
+    }
+
+    void use() const {
+        GLStateCache::current().useProgram(ID);
+    }
+
+    // One invocation per item, rounded up to whole work groups of groupSize
+    void dispatch(GLuint items, GLuint groupSize) const {
+        if (items == 0)
+            return;
+        use();
+        glDispatchCompute((items + groupSize - 1) / groupSize, 1, 1);
+    }
+
+    // One invocation per texel of a width x height grid, in groupSize x groupSize work groups
+    void dispatch(GLuint width, GLuint height, GLuint groupSize) const {
+        if (width == 0 || height == 0)
+            return;
+        use();
+        glDispatchCompute((width + groupSize - 1) / groupSize, (height + groupSize - 1) / groupSize, 1);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/simd/platform.h>
+
+#if GLM_ARCH & GLM_ARCH_X86_BIT
+#define CPU_DISPATCH_X86 1
+#include <immintrin.h>
+#if GLM_COMPILER & GLM_COMPILER_VC
+#include <intrin.h>
+#endif
+#endif
+
+// Instruction sets the batch kernels (BatchFK, SphereCuller) are compiled for.
+// Kernels carry target attributes, so the pick happens at runtime regardless of -march
+enum class SimdPath { Scalar, SSE2, AVX2 };
+
+inline SimdPath detectSimdPath() {
+#ifdef CPU_DISPATCH_X86
+#if GLM_COMPILER & GLM_COMPILER_VC
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        if (fma && osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+            return SimdPath::AVX2;
+    }
+    return SimdPath::SSE2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SimdPath::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdPath::SSE2;
+#endif
+#endif
+    return SimdPath::Scalar;
+}
+
+inline const char* simdPathName(SimdPath path) {
+    switch (path) {
+    case SimdPath::AVX2: return "AVX2";
+    case SimdPath::SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
+
+#ifdef CPU_DISPATCH_X86
+#if GLM_COMPILER & GLM_COMPILER_VC
+#define CPU_TARGET_SSE2
+#define CPU_TARGET_AVX2
+#else
+#define CPU_TARGET_SSE2 __attribute__((target("sse2")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "cpu_dispatch.h"
+#include "kinematic_chain.h"
+
+#ifdef CPU_DISPATCH_X86
+#define FK_BATCH_X86 1
+#endif
+
+// Batch forward kinematics for many instances of one joint chain.
+// Angles come in structure-of-arrays form and every link matrix of every instance is produced
+// by an SSE2 or AVX2+FMA kernel picked at runtime, with a scalar fallback.
+class BatchFK {
+public:
+    using Path = SimdPath;
+
+    // Per-joint constants: R(theta) = A + cos(theta) * B + sin(theta) * C, row-major 3x3
+    struct JointConstants {
+        float A[9];
+        float B[9];
+        float C[9];
+        float pivot[3];
+        int parent;
+    };
+
+    Path path;
+
+    explicit BatchFK(const KinematicChain& chain) : path(detectPath()) {
+        joints.resize(chain.size());
+        for (size_t j = 0; j < chain.size(); j++) {
+            const Joint& joint = chain.joints[j];
+            glm::vec3 a = joint.axis;
+            JointConstants& k = joints[j];
+            // Rodrigues: R = c*I + s*[a]x + (1 - c)*a*a^T
+            const float cross[9] = { 0.0f, -a.z, a.y,
+                                     a.z, 0.0f, -a.x,
+                                     -a.y, a.x, 0.0f };
+            for (int row = 0; row < 3; row++) {
+                for (int col = 0; col < 3; col++) {
+                    int e = row * 3 + col;
+                    float outer = a[row] * a[col];
+                    k.A[e] = outer;
+                    k.B[e] = (row == col ? 1.0f : 0.0f) - outer;
+                    k.C[e] = cross[e];
+                }
+            }
+            k.pivot[0] = joint.pivot.x;
+            k.pivot[1] = joint.pivot.y;
+            k.pivot[2] = joint.pivot.z;
+            k.parent = joint.parent;
+        }
+        order = chain.evaluationOrder();
+        // Widest kernel: 12 floats (3x4 world matrix) per joint for each of 8 lanes
+        scratch.resize(joints.size() * 12 * 8);
+    }
+
+    size_t jointCount() const { return joints.size(); }
+
+    // angles[j * instanceStride + i] is joint j of instance i in radians (instanceStride >= instanceCount).
+    // out receives instanceCount * jointCount() matrices, out[i * jointCount() + j] = world matrix of link j.
+    // Kernels share one scratch buffer, so a BatchFK evaluates on one thread at a time
+    void evaluate(const float* angles, size_t instanceCount, size_t instanceStride, glm::mat4* out) const {
+        if (joints.empty() || instanceCount == 0)
+            return;
+#ifdef FK_BATCH_X86
+        if (path == Path::AVX2) {
+            evaluateAVX2(joints.data(), order.data(), joints.size(), angles, instanceCount, instanceStride, out, scratch.data());
+            return;
+        }
+        if (path == Path::SSE2) {
+            evaluateSSE2(joints.data(), order.data(), joints.size(), angles, instanceCount, instanceStride, out, scratch.data());
+            return;
+        }
+#endif
+        evaluateScalar(angles, instanceCount, instanceStride, out);
+    }
+
+    static Path detectPath() {
+        return detectSimdPath();
+    }
+
+    static const char* pathName(Path path) {
+        return simdPathName(path);
+    }
+
+private:
+    std::vector<JointConstants> joints;
+    std::vector<size_t> order;
+    mutable std::vector<float> scratch;
+
+    void evaluateScalar(const float* angles, size_t instanceCount, size_t instanceStride, glm::mat4* out) const {
+        const size_t count = joints.size();
+        for (size_t i = 0; i < instanceCount; i++) {
+            glm::mat4* world = out + i * count;
+            for (size_t j : order) {
+                const JointConstants& k = joints[j];
+                float theta = angles[j * instanceStride + i];
+                float c = std::cos(theta), s = std::sin(theta);
+
+                glm::mat4 local(1.0f);
+                for (int row = 0; row < 3; row++) {
+                    for (int col = 0; col < 3; col++) {
+                        int e = row * 3 + col;
+                        local[col][row] = k.A[e] + c * k.B[e] + s * k.C[e];
+                    }
+                }
+                glm::vec3 pivot(k.pivot[0], k.pivot[1], k.pivot[2]);
+                local[3] = glm::vec4(pivot - glm::mat3(local) * pivot, 1.0f);
+
+                world[j] = k.parent < 0 ? local : world[k.parent] * local;
+            }
+        }
+    }
+
+#ifdef FK_BATCH_X86
+    // SSE2: 4 instances per iteration
+#define FK_KERNEL_NAME evaluateSSE2
+#define FK_TARGET static CPU_TARGET_SSE2
+#define FK_W 4
+#define FK_V __m128
+#define FK_VI __m128i
+#define FK_LOAD(p) _mm_loadu_ps(p)
+#define FK_STORE(p, v) _mm_storeu_ps(p, v)
+#define FK_SET1(f) _mm_set1_ps(f)
+#define FK_ADD(a, b) _mm_add_ps(a, b)
+#define FK_SUB(a, b) _mm_sub_ps(a, b)
+#define FK_MUL(a, b) _mm_mul_ps(a, b)
+#define FK_FMADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define FK_XOR(a, b) _mm_xor_ps(a, b)
+#define FK_SELECT(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+#define FK_CVT_ROUND(v) _mm_cvtps_epi32(v)
+#define FK_CVT_FLOAT(vi) _mm_cvtepi32_ps(vi)
+#define FK_CAST_PS(vi) _mm_castsi128_ps(vi)
+#define FK_SET1_I(i) _mm_set1_epi32(i)
+#define FK_AND_I(a, b) _mm_and_si128(a, b)
+#define FK_ADD_I(a, b) _mm_add_epi32(a, b)
+#define FK_CMPEQ_I(a, b) _mm_cmpeq_epi32(a, b)
+#define FK_SLLI(vi, n) _mm_slli_epi32(vi, n)
+#include "fk_batch_kernel.inl"
+#undef FK_KERNEL_NAME
+#undef FK_TARGET
+#undef FK_W
+#undef FK_V
+#undef FK_VI
+#undef FK_LOAD
+#undef FK_STORE
+#undef FK_SET1
+#undef FK_ADD
+#undef FK_SUB
+#undef FK_MUL
+#undef FK_FMADD
+#undef FK_XOR
+#undef FK_SELECT
+#undef FK_CVT_ROUND
+#undef FK_CVT_FLOAT
+#undef FK_CAST_PS
+#undef FK_SET1_I
+#undef FK_AND_I
+#undef FK_ADD_I
+#undef FK_CMPEQ_I
+#undef FK_SLLI
+
+    // AVX2 + FMA: 8 instances per iteration
+#define FK_KERNEL_NAME evaluateAVX2
+#define FK_TARGET static CPU_TARGET_AVX2
+#define FK_W 8
+#define FK_V __m256
+#define FK_VI __m256i
+#define FK_LOAD(p) _mm256_loadu_ps(p)
+#define FK_STORE(p, v) _mm256_storeu_ps(p, v)
+#define FK_SET1(f) _mm256_set1_ps(f)
+#define FK_ADD(a, b) _mm256_add_ps(a, b)
+#define FK_SUB(a, b) _mm256_sub_ps(a, b)
+#define FK_MUL(a, b) _mm256_mul_ps(a, b)
+#define FK_FMADD(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define FK_XOR(a, b) _mm256_xor_ps(a, b)
+#define FK_SELECT(mask, a, b) _mm256_blendv_ps(b, a, mask)
+#define FK_CVT_ROUND(v) _mm256_cvtps_epi32(v)
+#define FK_CVT_FLOAT(vi) _mm256_cvtepi32_ps(vi)
+#define FK_CAST_PS(vi) _mm256_castsi256_ps(vi)
+#define FK_SET1_I(i) _mm256_set1_epi32(i)
+#define FK_AND_I(a, b) _mm256_and_si256(a, b)
+#define FK_ADD_I(a, b) _mm256_add_epi32(a, b)
+#define FK_CMPEQ_I(a, b) _mm256_cmpeq_epi32(a, b)
+#define FK_SLLI(vi, n) _mm256_slli_epi32(vi, n)
+#include "fk_batch_kernel.inl"
+#undef FK_KERNEL_NAME
+#undef FK_TARGET
+#undef FK_W
+#undef FK_V
+#undef FK_VI
+#undef FK_LOAD
+#undef FK_STORE
+#undef FK_SET1
+#undef FK_ADD
+#undef FK_SUB
+#undef FK_MUL
+#undef FK_FMADD
+#undef FK_XOR
+#undef FK_SELECT
+#undef FK_CVT_ROUND
+#undef FK_CVT_FLOAT
+#undef FK_CAST_PS
+#undef FK_SET1_I
+#undef FK_AND_I
+#undef FK_ADD_I
+#undef FK_CMPEQ_I
+#undef FK_SLLI
+#endif
+};
\ No newline at end of file
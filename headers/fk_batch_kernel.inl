@@ -0,0 +1,116 @@
+// Batch forward-kinematics kernel body, instantiated by fk_batch.h once per instruction set.
+// The includer defines FK_KERNEL_NAME, FK_TARGET and the FK_* vector operations below.
+
+FK_TARGET inline void FK_KERNEL_NAME(const BatchFK::JointConstants* joints, const size_t* order, size_t jointCount,
+    const float* angles, size_t instanceCount, size_t instanceStride, glm::mat4* out, float* scratch)
+{
+    const FK_V halfPiInv = FK_SET1(0.636619772f);
+    const FK_V dp1 = FK_SET1(1.5703125f);
+    const FK_V dp2 = FK_SET1(4.837512969970703125e-4f);
+    const FK_V dp3 = FK_SET1(7.54978995489188216e-8f);
+    const FK_V s1 = FK_SET1(-1.6666654611e-1f);
+    const FK_V s2 = FK_SET1(8.3321608736e-3f);
+    const FK_V s3 = FK_SET1(-1.9515295891e-4f);
+    const FK_V c1 = FK_SET1(4.166664568298827e-2f);
+    const FK_V c2 = FK_SET1(-1.388731625493765e-3f);
+    const FK_V c3 = FK_SET1(2.443315711809948e-5f);
+    const FK_V half = FK_SET1(0.5f);
+    const FK_V one = FK_SET1(1.0f);
+    const FK_VI intOne = FK_SET1_I(1);
+    const FK_VI intTwo = FK_SET1_I(2);
+
+    alignas(32) float lanes[12][FK_W];
+    alignas(32) float tailAngles[FK_W];
+
+    for (size_t base = 0; base < instanceCount; base += FK_W) {
+        const size_t active = instanceCount - base < FK_W ? instanceCount - base : FK_W;
+
+        for (size_t n = 0; n < jointCount; n++) {
+            const size_t j = order[n];
+            const BatchFK::JointConstants& k = joints[j];
+
+            // Load this joint's angle for FK_W instances, zero-padding the tail batch
+            const float* src = angles + j * instanceStride + base;
+            FK_V theta;
+            if (active == FK_W) {
+                theta = FK_LOAD(src);
+            }
+            else {
+                for (size_t l = 0; l < FK_W; l++) tailAngles[l] = l < active ? src[l] : 0.0f;
+                theta = FK_LOAD(tailAngles);
+            }
+
+            // sincos: reduce by multiples of pi/2, minimax polynomials on [-pi/4, pi/4]
+            FK_VI q = FK_CVT_ROUND(FK_MUL(theta, halfPiInv));
+            FK_V y = FK_CVT_FLOAT(q);
+            FK_V r = FK_SUB(theta, FK_MUL(y, dp1));
+            r = FK_SUB(r, FK_MUL(y, dp2));
+            r = FK_SUB(r, FK_MUL(y, dp3));
+            FK_V r2 = FK_MUL(r, r);
+            FK_V sinPoly = FK_FMADD(FK_MUL(r, r2), FK_FMADD(FK_FMADD(s3, r2, s2), r2, s1), r);
+            FK_V cosPoly = FK_FMADD(FK_MUL(r2, r2), FK_FMADD(FK_FMADD(c3, r2, c2), r2, c1), FK_SUB(one, FK_MUL(half, r2)));
+
+            FK_V swap = FK_CAST_PS(FK_CMPEQ_I(FK_AND_I(q, intOne), intOne));
+            FK_V sinSign = FK_CAST_PS(FK_SLLI(FK_AND_I(q, intTwo), 30));
+            FK_V cosSign = FK_CAST_PS(FK_SLLI(FK_AND_I(FK_ADD_I(q, intOne), intTwo), 30));
+            FK_V s = FK_XOR(FK_SELECT(swap, cosPoly, sinPoly), sinSign);
+            FK_V c = FK_XOR(FK_SELECT(swap, sinPoly, cosPoly), cosSign);
+
+            // Local rotation R = A + c*B + s*C and translation t = pivot - R * pivot
+            FK_V R[9];
+            for (int e = 0; e < 9; e++) {
+                R[e] = FK_FMADD(s, FK_SET1(k.C[e]), FK_FMADD(c, FK_SET1(k.B[e]), FK_SET1(k.A[e])));
+            }
+            const FK_V px = FK_SET1(k.pivot[0]), py = FK_SET1(k.pivot[1]), pz = FK_SET1(k.pivot[2]);
+            FK_V t[3];
+            for (int i = 0; i < 3; i++) {
+                FK_V rp = FK_FMADD(R[i * 3 + 2], pz, FK_FMADD(R[i * 3 + 1], py, FK_MUL(R[i * 3], px)));
+                t[i] = FK_SUB(FK_SET1(k.pivot[i]), rp);
+            }
+
+            // World = parent world * local; 3x4 affine, rows stored as 12 SoA lanes
+            float* dst = scratch + j * 12 * FK_W;
+            FK_V W[12];
+            if (k.parent < 0) {
+                for (int i = 0; i < 3; i++) {
+                    W[i * 4 + 0] = R[i * 3 + 0];
+                    W[i * 4 + 1] = R[i * 3 + 1];
+                    W[i * 4 + 2] = R[i * 3 + 2];
+                    W[i * 4 + 3] = t[i];
+                }
+            }
+            else {
+                const float* par = scratch + static_cast<size_t>(k.parent) * 12 * FK_W;
+                for (int i = 0; i < 3; i++) {
+                    FK_V p0 = FK_LOAD(par + (i * 4 + 0) * FK_W);
+                    FK_V p1 = FK_LOAD(par + (i * 4 + 1) * FK_W);
+                    FK_V p2 = FK_LOAD(par + (i * 4 + 2) * FK_W);
+                    FK_V p3 = FK_LOAD(par + (i * 4 + 3) * FK_W);
+                    for (int col = 0; col < 3; col++) {
+                        W[i * 4 + col] = FK_FMADD(p2, R[6 + col], FK_FMADD(p1, R[3 + col], FK_MUL(p0, R[col])));
+                    }
+                    W[i * 4 + 3] = FK_ADD(FK_FMADD(p2, t[2], FK_FMADD(p1, t[1], FK_MUL(p0, t[0]))), p3);
+                }
+            }
+            for (int e = 0; e < 12; e++) {
+                FK_STORE(dst + e * FK_W, W[e]);
+                FK_STORE(lanes[e], W[e]);
+            }
+
+            // Scatter into column-major glm::mat4, one per instance
+            for (size_t l = 0; l < active; l++) {
+                glm::mat4& m = out[(base + l) * jointCount + j];
+                for (int i = 0; i < 3; i++) {
+                    m[0][i] = lanes[i * 4 + 0][l];
+                    m[1][i] = lanes[i * 4 + 1][l];
+                    m[2][i] = lanes[i * 4 + 2][l];
+                    m[3][i] = lanes[i * 4 + 3][l];
+                }
+                m[0][3] = 0.0f;
+                m[1][3] = 0.0f;
+                m[2][3] = 0.0f;
+                m[3][3] = 1.0f;
+            }
+        }
+    }
+}
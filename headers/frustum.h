@@ -0,0 +1,196 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "cpu_dispatch.h"
+
+// View frustum as six planes (left, right, bottom, top, near, far) extracted from a
+// projection * view matrix. A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+// A default-constructed frustum is disabled and never culls anything
+struct Frustum {
+    glm::vec4 planes[6];
+    bool enabled = false;
+
+    // Gribb-Hartmann extraction from the rows of the clip matrix; planes are normalized so
+    // the signed distances compare directly with bounding sphere radii
+    static Frustum fromMatrix(const glm::mat4& viewProjection) {
+        glm::vec4 row[4];
+        for (int r = 0; r < 4; r++)
+            row[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+
+        Frustum frustum;
+        frustum.planes[0] = row[3] + row[0];
+        frustum.planes[1] = row[3] - row[0];
+        frustum.planes[2] = row[3] + row[1];
+        frustum.planes[3] = row[3] - row[1];
+        frustum.planes[4] = row[3] + row[2];
+        frustum.planes[5] = row[3] - row[2];
+        for (glm::vec4& plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        frustum.enabled = true;
+        return frustum;
+    }
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        if (!enabled)
+            return true;
+        for (const glm::vec4& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // Local box [boundsMin, boundsMax] moved by an affine transform, tested as the oriented box it becomes
+    bool intersectsBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& transform) const {
+        if (!enabled)
+            return true;
+        glm::vec3 center = glm::vec3(transform * glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f));
+        glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+        glm::vec3 axes[3] = {
+            glm::vec3(transform[0]) * extent.x,
+            glm::vec3(transform[1]) * extent.y,
+            glm::vec3(transform[2]) * extent.z
+        };
+        for (const glm::vec4& plane : planes) {
+            glm::vec3 normal(plane);
+            float reach = std::fabs(glm::dot(normal, axes[0])) + std::fabs(glm::dot(normal, axes[1])) +
+                std::fabs(glm::dot(normal, axes[2]));
+            if (glm::dot(normal, center) + plane.w < -reach)
+                return false;
+        }
+        return true;
+    }
+};
+
+// Bounding spheres in structure-of-arrays form, the layout SphereCuller streams through
+struct SphereSet {
+    std::vector<float> x, y, z, radius;
+
+    size_t size() const { return radius.size(); }
+
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        radius.resize(count);
+    }
+
+    void set(size_t index, const glm::vec3& center, float r) {
+        x[index] = center.x;
+        y[index] = center.y;
+        z[index] = center.z;
+        radius[index] = r;
+    }
+
+    glm::vec3 center(size_t index) const {
+        return glm::vec3(x[index], y[index], z[index]);
+    }
+};
+
+// Largest axis scale of an affine transform, for moving a bounding sphere radius with it
+inline float maxAxisScale(const glm::mat4& transform) {
+    float sx = glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0]));
+    float sy = glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]));
+    float sz = glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]));
+    return std::sqrt(glm::max(sx, glm::max(sy, sz)));
+}
+
+// Tests many spheres against a frustum, 4 (SSE2) or 8 (AVX2+FMA) per iteration with the
+// kernel picked at runtime, and a scalar fallback
+class SphereCuller {
+public:
+    SimdPath path = detectSimdPath();
+
+    // visible[k] = 1 when sphere k intersects the frustum, 0 otherwise; returns the visible count
+    size_t cull(const Frustum& frustum, const SphereSet& spheres, size_t first, size_t count, uint8_t* visible) const {
+        if (!frustum.enabled) {
+            for (size_t k = 0; k < count; k++)
+                visible[k] = 1;
+            return count;
+        }
+        const float* x = spheres.x.data() + first;
+        const float* y = spheres.y.data() + first;
+        const float* z = spheres.z.data() + first;
+        const float* r = spheres.radius.data() + first;
+        size_t done = 0, visibleCount = 0;
+#ifdef CPU_DISPATCH_X86
+        if (path == SimdPath::AVX2)
+            done = cullAVX2(frustum.planes, x, y, z, r, count, visible, visibleCount);
+        else if (path == SimdPath::SSE2)
+            done = cullSSE2(frustum.planes, x, y, z, r, count, visible, visibleCount);
+#endif
+        for (size_t k = done; k < count; k++) {
+            bool inside = true;
+            for (const glm::vec4& plane : frustum.planes)
+                inside = inside && plane.x * x[k] + plane.y * y[k] + plane.z * z[k] + plane.w >= -r[k];
+            visible[k] = inside ? 1 : 0;
+            visibleCount += inside ? 1 : 0;
+        }
+        return visibleCount;
+    }
+
+private:
+#ifdef CPU_DISPATCH_X86
+    // Both kernels return how many leading spheres they handled; the rest go to the scalar tail
+    static CPU_TARGET_SSE2 size_t cullSSE2(const glm::vec4* planes, const float* x, const float* y, const float* z,
+        const float* r, size_t count, uint8_t* visible, size_t& visibleCount) {
+        size_t k = 0;
+        __m128i counts = _mm_setzero_si128();
+        for (; k + 4 <= count; k += 4) {
+            __m128 px = _mm_loadu_ps(x + k), py = _mm_loadu_ps(y + k), pz = _mm_loadu_ps(z + k);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + k));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), px),
+                    _mm_mul_ps(_mm_set1_ps(planes[p].y), py)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), pz), _mm_set1_ps(planes[p].w)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+            }
+            // All-ones lanes become 1, narrowed to 4 bytes and written with one store
+            __m128i bits = _mm_srli_epi32(_mm_castps_si128(inside), 31);
+            counts = _mm_add_epi32(counts, bits);
+            __m128i words = _mm_packs_epi32(bits, bits);
+            int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+            std::memcpy(visible + k, &bytes, sizeof(bytes));
+        }
+        alignas(16) uint32_t laneCounts[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneCounts), counts);
+        for (uint32_t laneCount : laneCounts)
+            visibleCount += laneCount;
+        return k;
+    }
+
+    static CPU_TARGET_AVX2 size_t cullAVX2(const glm::vec4* planes, const float* x, const float* y, const float* z,
+        const float* r, size_t count, uint8_t* visible, size_t& visibleCount) {
+        size_t k = 0;
+        __m256i counts = _mm256_setzero_si256();
+        for (; k + 8 <= count; k += 8) {
+            __m256 px = _mm256_loadu_ps(x + k), py = _mm256_loadu_ps(y + k), pz = _mm256_loadu_ps(z + k);
+            __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + k));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; p++) {
+                __m256 d = _mm256_fmadd_ps(_mm256_set1_ps(planes[p].x), px,
+                    _mm256_fmadd_ps(_mm256_set1_ps(planes[p].y), py,
+                    _mm256_fmadd_ps(_mm256_set1_ps(planes[p].z), pz, _mm256_set1_ps(planes[p].w))));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+            }
+            // All-ones lanes become 1, narrowed to 8 bytes and written with one store
+            __m256i bits = _mm256_srli_epi32(_mm256_castps_si256(inside), 31);
+            counts = _mm256_add_epi32(counts, bits);
+            __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(visible + k), _mm_packus_epi16(words, words));
+        }
+        alignas(32) uint32_t laneCounts[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(laneCounts), counts);
+        for (uint32_t laneCount : laneCounts)
+            visibleCount += laneCount;
+        return k;
+    }
+#endif
+};
\ No newline at end of file
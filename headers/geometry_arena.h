@@ -0,0 +1,190 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "indirect_draw.h"
+#include "gl_state.h"
+
+// Per-mesh position decode for VERTEX_FORMAT_PACKED: position = offset + unorm * scale
+struct MeshDequant {
+    glm::vec4 offset;
+    glm::vec4 scale;
+};
+
+// One vertex buffer, one index buffer and one VAO shared by all meshes of a model.
+// Meshes are addressed by base vertex / first index, which indirect draw commands carry.
+class GeometryArena {
+public:
+    unsigned int VAO = 0;
+    VertexFormat format = VERTEX_FORMAT_FLOAT;
+    // GL_UNSIGNED_SHORT when every mesh has at most 65536 vertices, GL_UNSIGNED_INT otherwise
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    GeometryArena() = default;
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    GeometryArena(GeometryArena&& other) noexcept {
+        swap(other);
+    }
+
+    GeometryArena& operator=(GeometryArena&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~GeometryArena() {
+        release();
+    }
+
+    void allocate(size_t vertexCapacity, size_t indexCapacity, VertexFormat format = VERTEX_FORMAT_FLOAT,
+        GLenum indexType = GL_UNSIGNED_INT) {
+        release();
+        this->format = format;
+        this->indexType = indexType;
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        GLStateCache::current().bindVertexArray(VAO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexCapacity * vertexStride(), NULL, GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCapacity * indexSize(), NULL, GL_STATIC_DRAW);
+
+        if (format == VERTEX_FORMAT_PACKED) {
+            // vertex pos, unorm16 inside the mesh bounds
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Position));
+
+            // vertex normals, octahedral snorm16
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+        }
+        else {
+            // vertex pos
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+
+            // vertex normals
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        }
+
+        vertexCursor = 0;
+        indexCursor = 0;
+    }
+
+    // Copies the mesh geometry behind the previous one and records its offsets in the mesh
+    void append(Mesh& mesh, const Vertex* vertexData, const unsigned int* indexData) {
+        mesh.baseVertex = static_cast<GLint>(vertexCursor);
+        mesh.firstIndex = static_cast<unsigned int>(indexCursor);
+
+        const void* uploadData = vertexData;
+        if (format == VERTEX_FORMAT_PACKED) {
+            glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+            glm::vec3 invExtent(
+                extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+            packScratch.resize(mesh.vertexCount);
+            for (unsigned int i = 0; i < mesh.vertexCount; i++)
+                packScratch[i] = packVertex(vertexData[i], mesh.boundsMin, invExtent);
+            uploadData = packScratch.data();
+            dequant.push_back({ glm::vec4(mesh.boundsMin, 0.0f), glm::vec4(extent, 0.0f) });
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, vertexCursor * vertexStride(), mesh.vertexCount * vertexStride(), uploadData);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        const void* indexUpload = indexData;
+        if (indexType == GL_UNSIGNED_SHORT) {
+            shortScratch.assign(indexData, indexData + mesh.indexCount);
+            indexUpload = shortScratch.data();
+        }
+
+        // The element buffer binding is VAO state
+        GLStateCache::current().bindVertexArray(VAO);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indexCursor * indexSize(), mesh.indexCount * indexSize(), indexUpload);
+
+        vertexCursor += mesh.vertexCount;
+        indexCursor += mesh.indexCount;
+    }
+
+    // Uploads the per-mesh decode table once every mesh has been appended
+    void finish() {
+        std::vector<PackedVertex>().swap(packScratch);
+        std::vector<uint16_t>().swap(shortScratch);
+        if (format != VERTEX_FORMAT_PACKED || dequant.empty())
+            return;
+        if (!dequantBuffer)
+            glGenBuffers(1, &dequantBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, dequantBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, dequant.size() * sizeof(MeshDequant), dequant.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    // Binds the decode table that shaders built with PACKED_VERTICES read by gl_DrawID
+    void bindDequant() const {
+        if (dequantBuffer)
+            GLStateCache::current().bindBufferBase(GL_SHADER_STORAGE_BUFFER, MESH_DEQUANT_BINDING, dequantBuffer);
+    }
+
+    size_t vertexStride() const {
+        return format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+    }
+
+    size_t indexSize() const {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+    }
+
+private:
+    unsigned int VBO = 0, EBO = 0;
+    unsigned int dequantBuffer = 0;
+    size_t vertexCursor = 0;
+    size_t indexCursor = 0;
+    std::vector<MeshDequant> dequant;
+    std::vector<PackedVertex> packScratch;
+    std::vector<uint16_t> shortScratch;
+
+    void release() {
+        GLStateCache& state = GLStateCache::current();
+        state.forgetVertexArray(VAO);
+        for (GLuint buffer : { VBO, EBO, dequantBuffer })
+            state.forgetBuffer(buffer);
+        if (VAO) glDeleteVertexArrays(1, &VAO);
+        if (VBO) glDeleteBuffers(1, &VBO);
+        if (EBO) glDeleteBuffers(1, &EBO);
+        if (dequantBuffer) glDeleteBuffers(1, &dequantBuffer);
+        VAO = VBO = EBO = dequantBuffer = 0;
+        vertexCursor = indexCursor = 0;
+        dequant.clear();
+        packScratch.clear();
+        shortScratch.clear();
+    }
+
+    void swap(GeometryArena& other) {
+        std::swap(VAO, other.VAO);
+        std::swap(VBO, other.VBO);
+        std::swap(EBO, other.EBO);
+        std::swap(dequantBuffer, other.dequantBuffer);
+        std::swap(format, other.format);
+        dequant.swap(other.dequant);
+        packScratch.swap(other.packScratch);
+        shortScratch.swap(other.shortScratch);
+        std::swap(indexType, other.indexType);
+        std::swap(vertexCursor, other.vertexCursor);
+        std::swap(indexCursor, other.indexCursor);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Shadow of the GL bindings the renderer changes between draws: program, vertex array, the
+// indirect draw and parameter buffers, and the indexed uniform/storage buffer slots (buffer
+// plus bound range). A bind of what the slot already holds is dropped before it reaches the
+// driver. Only works if every bind of these goes through here; deleting a bound object resets
+// the GL binding and frees the name for reuse, so owners call the matching forget*() when
+// they delete
+class GLStateCache {
+public:
+    static const GLuint kIndexedSlots = 16;
+
+    // Binds passed on to GL and binds dropped as redundant since the last resetStats()
+    struct Stats {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    // The application renders through one context on one thread
+    static GLStateCache& current() {
+        static GLStateCache cache;
+        return cache;
+    }
+
+    void useProgram(GLuint program) {
+        if (change(boundProgram, program))
+            glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vertexArray) {
+        if (change(boundVertexArray, vertexArray))
+            glBindVertexArray(vertexArray);
+    }
+
+    // Non-indexed targets other than the indirect draw/parameter buffers are only bound around
+    // uploads and are not tracked
+    void bindBuffer(GLenum target, GLuint buffer) {
+        GLuint* slot = targetSlot(target);
+        if (!slot) {
+            stats.issued++;
+            glBindBuffer(target, buffer);
+        }
+        else if (change(*slot, buffer)) {
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        IndexedSlot* slot = indexedSlot(target, index);
+        if (!slot) {
+            stats.issued++;
+            glBindBufferBase(target, index, buffer);
+        }
+        else if (change(*slot, { buffer, 0, 0 })) {
+            glBindBufferBase(target, index, buffer);
+        }
+    }
+
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        IndexedSlot* slot = indexedSlot(target, index);
+        if (!slot) {
+            stats.issued++;
+            glBindBufferRange(target, index, buffer, offset, size);
+        }
+        else if (change(*slot, { buffer, offset, size })) {
+            glBindBufferRange(target, index, buffer, offset, size);
+        }
+    }
+
+    void forgetProgram(GLuint program) {
+        forget(&boundProgram, 1, program);
+    }
+
+    void forgetVertexArray(GLuint vertexArray) {
+        forget(&boundVertexArray, 1, vertexArray);
+    }
+
+    void forgetBuffer(GLuint buffer) {
+        forget(&drawIndirectBuffer, 1, buffer);
+        forget(&parameterBuffer, 1, buffer);
+        for (GLuint i = 0; i < kIndexedSlots; i++) {
+            if (uniformSlots[i].buffer == buffer)
+                uniformSlots[i] = IndexedSlot();
+            if (storageSlots[i].buffer == buffer)
+                storageSlots[i] = IndexedSlot();
+        }
+    }
+
+    // Forgets everything, e.g. after code that binds with raw GL calls
+    void invalidate() {
+        boundProgram = boundVertexArray = kUnknown;
+        drawIndirectBuffer = parameterBuffer = kUnknown;
+        for (GLuint i = 0; i < kIndexedSlots; i++)
+            uniformSlots[i] = storageSlots[i] = IndexedSlot();
+    }
+
+    const Stats& statistics() const {
+        return stats;
+    }
+
+    void resetStats() {
+        stats = Stats();
+    }
+
+private:
+    // Never a valid GL name, so the first bind of every slot goes through
+    static const GLuint kUnknown = ~0u;
+
+    // size 0 is a glBindBufferBase of the whole buffer
+    struct IndexedSlot {
+        GLuint buffer = kUnknown;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    GLuint boundProgram;
+    GLuint boundVertexArray;
+    GLuint drawIndirectBuffer;
+    GLuint parameterBuffer;
+    IndexedSlot uniformSlots[kIndexedSlots];
+    IndexedSlot storageSlots[kIndexedSlots];
+    Stats stats;
+
+    GLStateCache() {
+        invalidate();
+    }
+
+    bool change(GLuint& slot, GLuint value) {
+        if (slot == value) {
+            stats.skipped++;
+            return false;
+        }
+        slot = value;
+        stats.issued++;
+        return true;
+    }
+
+    bool change(IndexedSlot& slot, const IndexedSlot& value) {
+        if (slot.buffer == value.buffer && slot.offset == value.offset && slot.size == value.size) {
+            stats.skipped++;
+            return false;
+        }
+        slot = value;
+        stats.issued++;
+        return true;
+    }
+
+    GLuint* targetSlot(GLenum target) {
+        switch (target) {
+        case GL_DRAW_INDIRECT_BUFFER: return &drawIndirectBuffer;
+        case GL_PARAMETER_BUFFER: return &parameterBuffer;
+        default: return nullptr;
+        }
+    }
+
+    IndexedSlot* indexedSlot(GLenum target, GLuint index) {
+        if (index >= kIndexedSlots)
+            return nullptr;
+        switch (target) {
+        case GL_UNIFORM_BUFFER: return &uniformSlots[index];
+        case GL_SHADER_STORAGE_BUFFER: return &storageSlots[index];
+        default: return nullptr;
+        }
+    }
+
+    static void forget(GLuint* slots, GLuint count, GLuint name) {
+        for (GLuint i = 0; i < count; i++) {
+            if (slots[i] == name)
+                slots[i] = kUnknown;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,257 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "indirect_draw.h"
+#include "uniform_block.h"
+#include "compute_shader.h"
+#include "frustum.h"
+#include "lod.h"
+#include "hiz.h"
+
+// std140 mirror of the CullData block in shaders/cull.comp
+struct CullData {
+    glm::vec4 planes[6];
+    glm::vec3 cameraPos;
+    float pixelsPerUnit;
+    float maxPixelError;
+    GLuint instanceCount;
+    GLuint meshCount;
+    GLuint frustumEnabled;
+    glm::mat4 viewProjection;
+    glm::vec2 hiZSize;
+    GLuint hiZLevels;
+    GLuint occlusionEnabled;
+};
+
+static_assert(sizeof(CullData) == 208, "CullData must match the std140 layout");
+
+// std430 mirrors of the per-mesh table read by both culling passes
+struct CullLod {
+    GLuint firstIndex;
+    GLuint indexCount;
+    float error;
+    GLuint pad;
+};
+
+struct CullMesh {
+    glm::vec4 sphere;
+    GLuint part;
+    GLuint lodCount;
+    GLint baseVertex;
+    GLuint firstIndex;
+    GLuint material;
+    GLuint pad0, pad1, pad2;
+    CullLod lods[kMaxMeshLods];
+};
+
+static_assert(sizeof(CullMesh) == 112, "CullMesh must match the std430 layout");
+
+// Culls and LOD-selects instanced robots on the GPU and builds the indirect draw list there,
+// so the CPU only uploads joint angles. The cull pass buckets visible robots per (mesh, level),
+// the compact pass turns each non-empty bucket into one command, and the draw count is read
+// back by glMultiDrawElementsIndirectCount without a CPU round trip.
+//
+// With occlusion culling a frame runs in two phases. PHASE_VISIBLE draws what was visible last
+// frame (frustum permitting); the Hi-Z pyramid is then built from that depth and PHASE_DISOCCLUDED
+// tests everything in the frustum against it, draws what became visible and records the
+// visibility for the next frame. Nothing visible is ever skipped, so no popping
+class GpuCuller {
+public:
+    enum CullPhase {
+        PHASE_VISIBLE = 0,
+        PHASE_DISOCCLUDED = 1
+    };
+
+    static const GLuint kGroupSize = 64;
+
+    // Meshes must already be appended to the geometry arena (firstIndex/baseVertex set)
+    GpuCuller(const std::vector<Mesh>& meshes, bool occlusion = true)
+        : occlusion(occlusion),
+        visibleProgram("shaders/cull.comp", "#define CULL_PHASE 0\n"),
+        disoccludedProgram("shaders/cull.comp", "#define CULL_PHASE 1\n"),
+        compactProgram("shaders/cull.comp", "#define COMPACT_PASS\n") {
+        std::vector<CullMesh> table(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++) {
+            const Mesh& mesh = meshes[m];
+            CullMesh& entry = table[m];
+            entry.sphere = glm::vec4(mesh.boundsCenter(), mesh.boundsRadius());
+            entry.part = mesh.part;
+            entry.lodCount = static_cast<GLuint>(std::min(mesh.lods.size(), kMaxMeshLods));
+            entry.baseVertex = mesh.baseVertex;
+            entry.firstIndex = mesh.firstIndex;
+            entry.material = mesh.materialIndex;
+            entry.pad0 = entry.pad1 = entry.pad2 = 0;
+            for (size_t l = 0; l < kMaxMeshLods; l++) {
+                entry.lods[l] = l < entry.lodCount
+                    ? CullLod{ mesh.lods[l].firstIndex, mesh.lods[l].indexCount, mesh.lods[l].error, 0 }
+                    : CullLod{ 0, 0, 0.0f, 0 };
+            }
+        }
+        meshCount = static_cast<GLuint>(meshes.size());
+        bucketCount = meshCount * static_cast<GLuint>(kMaxMeshLods);
+
+        glGenBuffers(1, &meshBuffer);
+        glGenBuffers(1, &visibilityBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, table.size() * sizeof(CullMesh), table.data(), GL_STATIC_DRAW);
+        for (PhaseBuffers& phase : phases) {
+            glGenBuffers(1, &phase.counterBuffer);
+            glGenBuffers(1, &phase.commandBuffer);
+            glGenBuffers(1, &phase.drawRecordBuffer);
+            glGenBuffers(1, &phase.instanceListBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, phase.counterBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, (1 + bucketCount) * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, phase.commandBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bucketCount * sizeof(DrawElementsIndirectCommand), NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, phase.drawRecordBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, bucketCount * sizeof(DrawRecord), NULL, GL_DYNAMIC_DRAW);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    GpuCuller(const GpuCuller&) = delete;
+    GpuCuller& operator=(const GpuCuller&) = delete;
+
+    ~GpuCuller() {
+        GLStateCache& state = GLStateCache::current();
+        state.forgetBuffer(meshBuffer);
+        state.forgetBuffer(visibilityBuffer);
+        for (const PhaseBuffers& phase : phases) {
+            for (GLuint buffer : { phase.counterBuffer, phase.commandBuffer, phase.drawRecordBuffer, phase.instanceListBuffer })
+                state.forgetBuffer(buffer);
+        }
+        glDeleteBuffers(1, &meshBuffer);
+        glDeleteBuffers(1, &visibilityBuffer);
+        for (PhaseBuffers& phase : phases) {
+            glDeleteBuffers(1, &phase.counterBuffer);
+            glDeleteBuffers(1, &phase.commandBuffer);
+            glDeleteBuffers(1, &phase.drawRecordBuffer);
+            glDeleteBuffers(1, &phase.instanceListBuffer);
+        }
+    }
+
+    // Only PHASE_VISIBLE runs when occlusion culling is off
+    bool occlusionEnabled() const {
+        return occlusion;
+    }
+
+    // Camera state of the next cull; a disabled frustum keeps every robot, a disabled LodView
+    // keeps level 0. viewProjection and the viewport size are used by the occlusion test
+    void setView(const Frustum& frustum, const LodView& lodView, const glm::mat4& viewProjection,
+        int viewportWidth, int viewportHeight, GLsizei instanceCount, PersistentRingBuffer* ring = nullptr) {
+        CullData data{};
+        for (int p = 0; p < 6; p++)
+            data.planes[p] = frustum.planes[p];
+        data.cameraPos = lodView.cameraPos;
+        data.pixelsPerUnit = lodView.pixelsPerUnit;
+        data.maxPixelError = lodView.maxPixelError;
+        data.instanceCount = static_cast<GLuint>(instanceCount);
+        data.meshCount = meshCount;
+        data.frustumEnabled = frustum.enabled ? 1 : 0;
+        data.viewProjection = viewProjection;
+        int hiZWidth = HiZPyramid::levelZeroSize(viewportWidth);
+        int hiZHeight = HiZPyramid::levelZeroSize(viewportHeight);
+        data.hiZSize = glm::vec2(hiZWidth, hiZHeight);
+        data.hiZLevels = static_cast<GLuint>(HiZPyramid::levelCount(hiZWidth, hiZHeight));
+        data.occlusionEnabled = occlusion ? 1 : 0;
+        cullData.update(data, ring);
+        this->viewportWidth = viewportWidth;
+        this->viewportHeight = viewportHeight;
+
+        // Every bucket can hold every robot
+        size_t listSize = size_t(bucketCount) * static_cast<size_t>(instanceCount);
+        for (PhaseBuffers& phase : phases) {
+            if (listSize > phase.listCapacity) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, phase.instanceListBuffer);
+                glBufferData(GL_COPY_WRITE_BUFFER, listSize * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+                phase.listCapacity = listSize;
+            }
+        }
+        // A new fleet starts with every robot treated as visible last frame
+        size_t pairs = size_t(meshCount) * static_cast<size_t>(instanceCount);
+        if (static_cast<GLuint>(instanceCount) != this->instanceCount) {
+            const GLuint visible = 1;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, visibilityBuffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, std::max(pairs, size_t(1)) * sizeof(GLuint), NULL, GL_DYNAMIC_DRAW);
+            glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &visible);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->instanceCount = static_cast<GLuint>(instanceCount);
+    }
+
+    // Runs the cull and compact passes of one phase; the robot instance buffers (joints,
+    // placements, angles) must be bound. PHASE_DISOCCLUDED builds the Hi-Z pyramid first from
+    // the depth of the bound framebuffer, so PHASE_VISIBLE must have been drawn into it
+    void cull(CullPhase phase) {
+        if (instanceCount == 0)
+            return;
+        if (phase == PHASE_DISOCCLUDED) {
+            hiZ.build(viewportWidth, viewportHeight);
+            hiZ.bind();
+        }
+        const PhaseBuffers& buffers = phases[phase];
+        GLStateCache& state = GLStateCache::current();
+        cullData.bind();
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_MESHES_BINDING, meshBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_VISIBILITY_BINDING, visibilityBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COUNTERS_BINDING, buffers.counterBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_LIST_BINDING, buffers.instanceListBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COMMANDS_BINDING, buffers.commandBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_RECORDS_BINDING, buffers.drawRecordBuffer);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers.counterBuffer);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        const ComputeShader& program = phase == PHASE_VISIBLE ? visibleProgram : disoccludedProgram;
+        program.dispatch(meshCount * instanceCount, kGroupSize);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        compactProgram.dispatch(bucketCount, kGroupSize);
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    // Draws what the last cull() of this phase produced; the arena VAO and the model program must be bound
+    void submit(CullPhase phase, GLenum indexType) const {
+        if (instanceCount == 0)
+            return;
+        const PhaseBuffers& buffers = phases[phase];
+        GLStateCache& state = GLStateCache::current();
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_RECORDS_BINDING, buffers.drawRecordBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_LIST_BINDING, buffers.instanceListBuffer);
+        state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, buffers.commandBuffer);
+        state.bindBuffer(GL_PARAMETER_BUFFER, buffers.counterBuffer);
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, indexType, (void*)0, 0, static_cast<GLsizei>(bucketCount), 0);
+    }
+
+private:
+    // Each phase writes its own list so the second cull never overwrites what the first draw reads
+    struct PhaseBuffers {
+        unsigned int counterBuffer = 0;
+        unsigned int commandBuffer = 0;
+        unsigned int drawRecordBuffer = 0;
+        unsigned int instanceListBuffer = 0;
+        size_t listCapacity = 0;
+    };
+
+    bool occlusion;
+    ComputeShader visibleProgram;
+    ComputeShader disoccludedProgram;
+    ComputeShader compactProgram;
+    UniformBlock<CullData> cullData{ CULL_DATA_BINDING };
+    HiZPyramid hiZ;
+    GLuint meshCount = 0;
+    GLuint bucketCount = 0;
+    GLuint instanceCount = 0;
+    int viewportWidth = 0, viewportHeight = 0;
+
+    unsigned int meshBuffer = 0;
+    // One flag per (mesh, robot): visible at the end of the previous frame
+    unsigned int visibilityBuffer = 0;
+    PhaseBuffers phases[2];
+};
\ No newline at end of file
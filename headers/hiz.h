@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "compute_shader.h"
+
+// Hierarchical-Z pyramid of the depth buffer for occlusion culling. build() copies the depth
+// of the bound read framebuffer and reduces it with shaders/hiz.comp; the culling shader then
+// samples the pyramid through texture unit kTextureUnit
+class HiZPyramid {
+public:
+    static const GLuint kTextureUnit = 0;
+    static const GLuint kGroupSize = 8;
+
+    // Pyramid level 0 size and mip count, valid after the first build()
+    int width = 0, height = 0;
+    int levels = 0;
+
+    HiZPyramid() : fromDepthProgram("shaders/hiz.comp", "#define HIZ_FROM_DEPTH\n"), reduceProgram("shaders/hiz.comp") {}
+
+    HiZPyramid(const HiZPyramid&) = delete;
+    HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+    ~HiZPyramid() {
+        release();
+    }
+
+    // Largest power of two that fits the viewport, so mips halve exactly
+    static int levelZeroSize(int viewportSize) {
+        int size = 1;
+        while (size * 2 <= viewportSize)
+            size *= 2;
+        return size;
+    }
+
+    // Mip levels down to 1x1 of a level 0 of width x height
+    static int levelCount(int width, int height) {
+        int count = 1;
+        while ((std::max(width, height) >> count) > 0)
+            count++;
+        return count;
+    }
+
+    // Rebuilds the pyramid from the depth of a viewportWidth x viewportHeight read framebuffer
+    void build(int viewportWidth, int viewportHeight) {
+        if (viewportWidth <= 0 || viewportHeight <= 0)
+            return;
+        if (viewportWidth != depthWidth || viewportHeight != depthHeight)
+            allocate(viewportWidth, viewportHeight);
+
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, depthWidth, depthHeight);
+
+        glActiveTexture(GL_TEXTURE0 + kTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glBindImageTexture(0, pyramidTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        fromDepthProgram.dispatch(width, height, kGroupSize);
+
+        for (int level = 1; level < levels; level++) {
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            glBindImageTexture(0, pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+            glBindImageTexture(1, pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+            reduceProgram.dispatch(std::max(width >> level, 1), std::max(height >> level, 1), kGroupSize);
+        }
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    void bind() const {
+        glActiveTexture(GL_TEXTURE0 + kTextureUnit);
+        glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    }
+
+private:
+    ComputeShader fromDepthProgram;
+    ComputeShader reduceProgram;
+    unsigned int depthTexture = 0;
+    unsigned int pyramidTexture = 0;
+    int depthWidth = 0, depthHeight = 0;
+
+    void allocate(int viewportWidth, int viewportHeight) {
+        release();
+        depthWidth = viewportWidth;
+        depthHeight = viewportHeight;
+        width = levelZeroSize(viewportWidth);
+        height = levelZeroSize(viewportHeight);
+        levels = levelCount(width, height);
+
+        // Same format as the window and OffscreenTarget depth buffers, which glCopyTexSubImage2D needs
+        glGenTextures(1, &depthTexture);
+        glBindTexture(GL_TEXTURE_2D, depthTexture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, depthWidth, depthHeight);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenTextures(1, &pyramidTexture);
+        glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void release() {
+        if (depthTexture) glDeleteTextures(1, &depthTexture);
+        if (pyramidTexture) glDeleteTextures(1, &pyramidTexture);
+        depthTexture = pyramidTexture = 0;
+        depthWidth = depthHeight = 0;
+    }
+};
\ No newline at end of file
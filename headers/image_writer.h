@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+// Minimal writers for 8-bit RGB images whose rows are stored bottom-up, as glReadPixels returns them
+namespace ImageWriter {
+
+    inline bool writePPM(const std::string& path, const unsigned char* rgb, int width, int height) {
+        FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out) {
+            std::cerr << "ERROR::IMAGE_WRITER::CANNOT_OPEN " << path << std::endl;
+            return false;
+        }
+        std::fprintf(out, "P6\n%d %d\n255\n", width, height);
+        bool ok = true;
+        for (int y = height - 1; y >= 0 && ok; y--) {
+            ok = std::fwrite(rgb + static_cast<size_t>(y) * width * 3, 1, static_cast<size_t>(width) * 3, out) == static_cast<size_t>(width) * 3;
+        }
+        return std::fclose(out) == 0 && ok;
+    }
+
+    inline uint32_t crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+        static uint32_t table[256];
+        static bool tableReady = false;
+        if (!tableReady) {
+            for (uint32_t n = 0; n < 256; n++) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            tableReady = true;
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // PNG with uncompressed (stored) deflate blocks: no zlib dependency and no CPU time spent compressing
+    inline bool writePNG(const std::string& path, const unsigned char* rgb, int width, int height) {
+        const size_t rowBytes = static_cast<size_t>(width) * 3 + 1;
+        std::vector<unsigned char> raw(rowBytes * height);
+        for (int y = 0; y < height; y++) {
+            unsigned char* row = raw.data() + y * rowBytes;
+            row[0] = 0;     // filter: none
+            const unsigned char* src = rgb + static_cast<size_t>(height - 1 - y) * width * 3;
+            std::copy(src, src + rowBytes - 1, row + 1);
+        }
+
+        std::vector<unsigned char> zlib;
+        zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+        zlib.push_back(0x78);
+        zlib.push_back(0x01);
+        uint32_t a = 1, b = 0;
+        size_t offset = 0;
+        do {
+            size_t block = std::min<size_t>(raw.size() - offset, 65535);
+            bool last = offset + block == raw.size();
+            zlib.push_back(last ? 1 : 0);
+            zlib.push_back(block & 0xFF);
+            zlib.push_back((block >> 8) & 0xFF);
+            zlib.push_back(~block & 0xFF);
+            zlib.push_back((~block >> 8) & 0xFF);
+            for (size_t i = 0; i < block; i++) {
+                unsigned char v = raw[offset + i];
+                zlib.push_back(v);
+                a = (a + v) % 65521;
+                b = (b + a) % 65521;
+            }
+            offset += block;
+        } while (offset < raw.size());
+        uint32_t adler = (b << 16) | a;
+        for (int shift = 24; shift >= 0; shift -= 8)
+            zlib.push_back((adler >> shift) & 0xFF);
+
+        FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out) {
+            std::cerr << "ERROR::IMAGE_WRITER::CANNOT_OPEN " << path << std::endl;
+            return false;
+        }
+        bool ok = true;
+        auto put32 = [](unsigned char* p, uint32_t v) {
+            p[0] = (v >> 24) & 0xFF; p[1] = (v >> 16) & 0xFF; p[2] = (v >> 8) & 0xFF; p[3] = v & 0xFF;
+        };
+        auto chunk = [&](const char* type, const unsigned char* data, size_t size) {
+            unsigned char header[8];
+            put32(header, static_cast<uint32_t>(size));
+            std::copy(type, type + 4, header + 4);
+            uint32_t crc = crc32(data, size, crc32(header + 4, 4));
+            unsigned char trailer[4];
+            put32(trailer, crc);
+            ok = ok && std::fwrite(header, 1, 8, out) == 8 &&
+                (size == 0 || std::fwrite(data, 1, size, out) == size) &&
+                std::fwrite(trailer, 1, 4, out) == 4;
+        };
+
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        ok = std::fwrite(signature, 1, 8, out) == 8;
+        unsigned char ihdr[13];
+        put32(ihdr, static_cast<uint32_t>(width));
+        put32(ihdr + 4, static_cast<uint32_t>(height));
+        ihdr[8] = 8;        // bit depth
+        ihdr[9] = 2;        // colour type: RGB
+        ihdr[10] = ihdr[11] = ihdr[12] = 0;
+        chunk("IHDR", ihdr, sizeof(ihdr));
+        chunk("IDAT", zlib.data(), zlib.size());
+        chunk("IEND", NULL, 0);
+        return std::fclose(out) == 0 && ok;
+    }
+
+    // Picks the format from the file extension (.png, anything else is written as PPM)
+    inline bool write(const std::string& path, const unsigned char* rgb, int width, int height) {
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".png") == 0)
+            return writePNG(path, rgb, width, height);
+        return writePPM(path, rgb, width, height);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include <vector>
+#include <cmath>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ring_buffer.h"
+#include "gl_state.h"
+
+// Shader storage binding points used by the model and culling shaders
+enum StorageBinding : GLuint {
+    MESH_TRANSFORMS_BINDING = 0,
+    JOINTS_BINDING = 1,
+    ROBOT_INSTANCES_BINDING = 2,
+    INSTANCE_ANGLES_BINDING = 3,
+    MESH_DEQUANT_BINDING = 4,
+    DRAW_RECORDS_BINDING = 5,
+    INSTANCE_LIST_BINDING = 6,
+    CULL_MESHES_BINDING = 7,
+    CULL_COUNTERS_BINDING = 8,
+    DRAW_COMMANDS_BINDING = 9,
+    CULL_VISIBILITY_BINDING = 10,
+    MATERIALS_BINDING = 11
+};
+
+// Layout consumed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Per-draw record read through gl_DrawID: the part (transform slot / joint), the mesh
+// (dequantization entry) and the material table entry the command draws
+struct DrawRecord {
+    GLuint part;
+    GLuint mesh;
+    GLuint material;
+};
+
+// std430 mirror of one MeshTransforms entry: the part's model matrix and its normal matrix,
+// computed once per transform change instead of per vertex. mat3 columns are padded to vec4
+struct PartTransform {
+    glm::mat4 model;
+    glm::vec4 normal[3];
+
+    static PartTransform from(const glm::mat4& model) {
+        PartTransform part;
+        part.model = model;
+        glm::mat3 normalMatrix = isRigid(model) ? glm::mat3(model) : glm::transpose(glm::inverse(glm::mat3(model)));
+        for (int c = 0; c < 3; c++)
+            part.normal[c] = glm::vec4(normalMatrix[c], 0.0f);
+        return part;
+    }
+
+    // Rotation plus translation: the inverse transpose of the upper 3x3 is the 3x3 itself
+    static bool isRigid(const glm::mat4& model) {
+        const float epsilon = 1e-5f;
+        glm::mat3 r(model);
+        glm::mat3 gram = glm::transpose(r) * r;
+        for (int c = 0; c < 3; c++) {
+            for (int row = 0; row < 3; row++) {
+                if (std::fabs(gram[c][row] - (c == row ? 1.0f : 0.0f)) > epsilon)
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+static_assert(sizeof(PartTransform) == 112, "PartTransform must match the std430 layout");
+
+// Indirect commands plus the SSBOs of per-part transforms, per-draw records and, for instanced
+// draws, the instance list each command's baseInstance points into. Each is a StreamBuffer, so
+// with a ring the GPU reads all of them straight from the ring.
+// Shaders resolve meshTransforms[drawRecords[gl_DrawID].part]
+class IndirectDrawBuffer {
+public:
+    GLsizei drawCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    IndirectDrawBuffer() = default;
+    IndirectDrawBuffer(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer& operator=(const IndirectDrawBuffer&) = delete;
+    IndirectDrawBuffer(IndirectDrawBuffer&&) = default;
+    IndirectDrawBuffer& operator=(IndirectDrawBuffer&&) = default;
+
+    // Holds one transform slot per part; indexType must match the arena
+    void create(size_t partCount, GLenum indexType) {
+        this->indexType = indexType;
+        std::vector<PartTransform> identity(partCount, PartTransform::from(glm::mat4(1.0f)));
+        transforms.assign(identity.data(), identity.size() * sizeof(PartTransform), nullptr);
+    }
+
+    // Replaces the draw list; records[i] describes commands[i]. Nothing is uploaded when the
+    // list is unchanged, so frames with a stable LOD selection cost no bandwidth
+    void setDraws(const std::vector<DrawElementsIndirectCommand>& commands, const std::vector<DrawRecord>& records,
+        PersistentRingBuffer* ring = nullptr) {
+        drawCount = static_cast<GLsizei>(commands.size());
+        if (commands.empty())
+            return;
+        this->commands.assign(commands.data(), commands.size() * sizeof(DrawElementsIndirectCommand), ring);
+        this->records.assign(records.data(), records.size() * sizeof(DrawRecord), ring);
+    }
+
+    // Instance ids for instanced draws; a command covers list[baseInstance, baseInstance + instanceCount)
+    void setInstanceList(const std::vector<GLuint>& list, PersistentRingBuffer* ring = nullptr) {
+        if (!list.empty())
+            instanceList.assign(list.data(), list.size() * sizeof(GLuint), ring);
+    }
+
+    // Updates transforms[first, first + count) in the matching SSBO slots
+    void setTransforms(const std::vector<PartTransform>& transforms, size_t first, size_t count, PersistentRingBuffer* ring = nullptr) {
+        this->transforms.write(first * sizeof(PartTransform), transforms.data() + first, count * sizeof(PartTransform), ring);
+    }
+
+    // Submits every command with one call; the arena VAO must be bound
+    void draw() const {
+        transforms.bind(GL_SHADER_STORAGE_BUFFER, MESH_TRANSFORMS_BINDING);
+        submit();
+    }
+
+    void submit() const {
+        if (drawCount == 0)
+            return;
+        GLStateCache& state = GLStateCache::current();
+        records.bind(GL_SHADER_STORAGE_BUFFER, DRAW_RECORDS_BINDING);
+        instanceList.bind(GL_SHADER_STORAGE_BUFFER, INSTANCE_LIST_BINDING);
+        StreamBuffer::Range commandRange = commands.range();
+        state.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRange.buffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, (void*)commandRange.offset, drawCount, 0);
+    }
+
+private:
+    StreamBuffer commands;
+    StreamBuffer transforms;
+    StreamBuffer records;
+    StreamBuffer instanceList;
+};
\ No newline at end of file
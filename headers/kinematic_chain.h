@@ -0,0 +1,159 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// One revolute joint; link i of the model (mesh i) rotates with joint i
+struct Joint {
+    std::string name;
+    int parent = -1;
+    glm::vec3 pivot = glm::vec3(0.0f);
+    glm::vec3 axis = glm::vec3(0.0f, 1.0f, 0.0f);
+    float minAngle = 0.0f;      // degrees
+    float maxAngle = 0.0f;      // degrees
+    float angle = 0.0f;         // degrees
+};
+
+// Parent-indexed joint hierarchy evaluated in topological order, so every link's world
+// matrix is computed once from its parent's cached result
+class KinematicChain {
+public:
+    std::vector<Joint> joints;
+    std::vector<glm::mat4> worldTransforms;
+
+    // Joints whose world matrix was recomputed by the last evaluate(), in evaluation order
+    std::vector<size_t> changedJoints;
+
+    // Text format, one joint per line ('#' starts a comment):
+    //   name parent pivotX pivotY pivotZ axisX axisY axisZ minAngle maxAngle
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "ERROR::KINEMATIC_CHAIN::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return false;
+        }
+
+        std::vector<Joint> parsed;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            ++lineNumber;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos)
+                line.erase(comment);
+
+            std::istringstream in(line);
+            Joint joint;
+            if (!(in >> joint.name))
+                continue;
+            if (!(in >> joint.parent
+                >> joint.pivot.x >> joint.pivot.y >> joint.pivot.z
+                >> joint.axis.x >> joint.axis.y >> joint.axis.z
+                >> joint.minAngle >> joint.maxAngle)) {
+                std::cout << "ERROR::KINEMATIC_CHAIN::BAD_LINE " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            // A zero axis would normalize to NaN and poison every transform below the joint
+            if (glm::dot(joint.axis, joint.axis) < 1e-12f) {
+                std::cout << "ERROR::KINEMATIC_CHAIN::ZERO_AXIS " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            joint.axis = glm::normalize(joint.axis);
+            joint.angle = glm::clamp(0.0f, joint.minAngle, joint.maxAngle);
+            parsed.push_back(joint);
+        }
+
+        joints = parsed;
+        if (!buildEvaluationOrder()) {
+            std::cout << "ERROR::KINEMATIC_CHAIN::INVALID_HIERARCHY " << path << std::endl;
+            joints.clear();
+            order.clear();
+            return false;
+        }
+        worldTransforms.assign(joints.size(), glm::mat4(1.0f));
+        dirty.assign(joints.size(), 1);
+        evaluate();
+        return true;
+    }
+
+    size_t size() const { return joints.size(); }
+
+    // Joint indices with every parent before its children
+    const std::vector<size_t>& evaluationOrder() const { return order; }
+
+    void setAngle(size_t index, float degrees) {
+        Joint& joint = joints[index];
+        float clamped = glm::clamp(degrees, joint.minAngle, joint.maxAngle);
+        if (clamped != joint.angle) {
+            joint.angle = clamped;
+            dirty[index] = 1;
+        }
+    }
+
+    bool isMovable(size_t index) const {
+        return joints[index].minAngle < joints[index].maxAngle;
+    }
+
+    // Rotation about the joint axis through its pivot
+    glm::mat4 localTransform(size_t index) const {
+        const Joint& joint = joints[index];
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), joint.pivot);
+        local = glm::rotate(local, glm::radians(joint.angle), joint.axis);
+        return glm::translate(local, -joint.pivot);
+    }
+
+    // Recomputes only dirty joints and their descendants; returns the number of updated joints.
+    // A frame without angle changes does no matrix work at all.
+    size_t evaluate() {
+        changedJoints.clear();
+        for (size_t index : order) {
+            const Joint& joint = joints[index];
+            // Parents precede children in order, so a recomputed parent has already marked us
+            if (!dirty[index] && (joint.parent < 0 || !dirty[joint.parent]))
+                continue;
+            dirty[index] = 1;
+            glm::mat4 local = localTransform(index);
+            worldTransforms[index] = joint.parent < 0 ? local : worldTransforms[joint.parent] * local;
+            changedJoints.push_back(index);
+        }
+        for (size_t index : changedJoints) {
+            dirty[index] = 0;
+        }
+        return changedJoints.size();
+    }
+
+private:
+    // Joint indices sorted so that parents always precede their children
+    std::vector<size_t> order;
+    std::vector<char> dirty;
+
+    bool buildEvaluationOrder() {
+        const int count = static_cast<int>(joints.size());
+        std::vector<std::vector<size_t>> children(joints.size());
+        order.clear();
+        order.reserve(joints.size());
+
+        for (int i = 0; i < count; ++i) {
+            int parent = joints[i].parent;
+            if (parent >= count || parent == i)
+                return false;
+            if (parent < 0)
+                order.push_back(i);
+            else
+                children[parent].push_back(i);
+        }
+
+        // Breadth-first from the roots; a cycle leaves joints unreached
+        for (size_t head = 0; head < order.size(); ++head) {
+            for (size_t child : children[order[head]]) {
+                order.push_back(child);
+            }
+        }
+        return order.size() == joints.size();
+    }
+};
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Camera state for choosing levels of detail by projected screen-space error
+struct LodView {
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    // Pixels covered by one model unit at distance 1: projection[1][1] * viewportHeight / 2
+    float pixelsPerUnit = 0.0f;
+    // Largest error in pixels a coarser level may introduce; <= 0 always draws level 0
+    float maxPixelError = 0.0f;
+
+    static LodView fromProjection(const glm::mat4& projection, const glm::vec3& cameraPos,
+        int viewportHeight, float maxPixelError) {
+        LodView view;
+        view.cameraPos = cameraPos;
+        view.pixelsPerUnit = projection[1][1] * 0.5f * static_cast<float>(viewportHeight);
+        view.maxPixelError = maxPixelError;
+        return view;
+    }
+
+    bool enabled() const {
+        return maxPixelError > 0.0f && pixelsPerUnit > 0.0f;
+    }
+
+    // Distance from the camera to the nearest point of a bounding sphere, never below a
+    // small epsilon so a camera inside the sphere gets level 0
+    float distanceTo(const glm::vec3& center, float radius) const {
+        return std::max(glm::length(center - cameraPos) - radius, 1e-3f);
+    }
+
+    // Coarsest level whose error stays under maxPixelError at this distance
+    unsigned int selectLevel(const Mesh& mesh, float distance) const {
+        if (!enabled())
+            return 0;
+        float maxError = maxPixelError * distance / pixelsPerUnit;
+        unsigned int level = 0;
+        for (unsigned int l = 1; l < mesh.lods.size(); l++) {
+            if (mesh.lods[l].error > maxError)
+                break;
+            level = l;
+        }
+        return level;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "indirect_draw.h"
+#include "gl_state.h"
+
+// std430 mirror of one entry of the Materials buffer in shaders/shader.frag; also stored as is
+// in the mesh cache. Phong reflectances, ambient.w = shininess
+struct Material {
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+
+    static Material make(const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular, float shininess) {
+        return { glm::vec4(ambient, shininess), glm::vec4(diffuse, 1.0f), glm::vec4(specular, 1.0f) };
+    }
+
+    // Used for meshes without a usable material (the old hard-coded gold)
+    static Material fallback() {
+        return make(glm::vec3(0.24725f, 0.1995f, 0.0745f), glm::vec3(0.75164f, 0.60648f, 0.22648f),
+            glm::vec3(0.628281f, 0.555802f, 0.366065f), 51.2f);
+    }
+};
+
+static_assert(sizeof(Material) == 48, "Material must match the std430 layout");
+
+// Every material of a model in one SSBO; draws select their entry through DrawRecord::material
+class MaterialTable {
+public:
+    unsigned int buffer = 0;
+
+    MaterialTable() = default;
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    MaterialTable(MaterialTable&& other) noexcept {
+        std::swap(buffer, other.buffer);
+    }
+
+    MaterialTable& operator=(MaterialTable&& other) noexcept {
+        std::swap(buffer, other.buffer);
+        return *this;
+    }
+
+    ~MaterialTable() {
+        if (buffer) {
+            GLStateCache::current().forgetBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+
+    void upload(const std::vector<Material>& materials) {
+        if (!buffer) glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(Material), materials.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void bind() const {
+        GLStateCache::current().bindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, buffer);
+    }
+};
\ No newline at end of file
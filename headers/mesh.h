@@ -1,58 +1,230 @@
 #pragma once
 #include <vector>
+#include <cfloat>
+#include <cstdint>
+#include <utility>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
-
-#include "shader.h"
+#include <glm/gtc/packing.hpp>
 
 struct Vertex {
     glm::vec3 Position;
     glm::vec3 Normal;
 };
 
+// Layout of the vertex buffer on the GPU. PACKED needs shaders built with PACKED_VERTICES
+enum VertexFormat {
+    VERTEX_FORMAT_FLOAT,   // Vertex as is, 24 bytes
+    VERTEX_FORMAT_PACKED   // PackedVertex, 12 bytes
+};
+
+// Position as unorm16 inside the mesh bounds (w unused), normal octahedral-encoded as 2x snorm16.
+// The per-mesh bounds needed to decode the position go to the MeshDequant storage buffer
+struct PackedVertex {
+    uint16_t Position[4];
+    uint32_t Normal;
+};
+static_assert(sizeof(PackedVertex) == 12, "PackedVertex must stay 12 bytes");
+
+inline glm::vec2 octahedralEncode(const glm::vec3& n) {
+    float l1 = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+    if (l1 == 0.0f)
+        return glm::vec2(0.0f);
+    glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+    if (n.z < 0.0f) {
+        glm::vec2 s(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+        p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * s;
+    }
+    return p;
+}
+
+inline PackedVertex packVertex(const Vertex& v, const glm::vec3& boundsMin, const glm::vec3& invExtent) {
+    PackedVertex packed;
+    glm::vec3 t = glm::clamp((v.Position - boundsMin) * invExtent, 0.0f, 1.0f);
+    glm::u16vec4 q = glm::packUnorm<uint16_t>(glm::vec4(t, 0.0f));
+    for (int k = 0; k < 4; k++)
+        packed.Position[k] = q[k];
+    packed.Normal = glm::packSnorm2x16(octahedralEncode(v.Normal));
+    return packed;
+}
+
+// What a Mesh keeps in system memory once its geometry has been uploaded to the GeometryArena
+enum GeometryResidency {
+    RESIDENCY_KEEP,     // full vertices/indices, e.g. for picking or collision
+    RESIDENCY_COMPACT,  // positions quantized to 16 bits inside the bounds, normals dropped
+    RESIDENCY_RELEASE   // nothing; Model::Rehydrate restores the full copy from the mesh cache
+};
+
+// One level of detail: an index range inside the mesh's indices (relative to the mesh's first
+// index) and the geometric error its simplification introduced, in model units
+struct MeshLod {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error;
+};
+
+// Level 0 plus up to three simplified levels
+const size_t kMaxMeshLods = 4;
+
+// CPU-side geometry of one model part plus its range inside the owning model's GeometryArena
 class Mesh {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    unsigned int VAO;
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices) {
-        this->vertices = vertices;
-        this->indices = indices;
-        setupMesh();
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    unsigned int materialIndex;
+    unsigned int vertexCount;
+    unsigned int indexCount;   // all levels of detail together
+
+    // lods[0] is the full mesh; coarser levels index the same vertices
+    std::vector<MeshLod> lods;
+
+    // Model part (transform and joint) the mesh belongs to; parts too large for 16-bit
+    // indices are split into several meshes of the same part
+    unsigned int part = 0;
+
+    // Filled in when the mesh is appended to a GeometryArena
+    GLint baseVertex = 0;
+    unsigned int firstIndex = 0;
+
+    GeometryResidency residency = RESIDENCY_KEEP;
+
+    // Takes the geometry by value so callers can move their buffers in without a copy
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, unsigned int materialIndex = 0)
+        : vertices(std::move(vertices)), indices(std::move(indices)) {
+        this->materialIndex = materialIndex;
+        vertexCount = static_cast<unsigned int>(this->vertices.size());
+        indexCount = static_cast<unsigned int>(this->indices.size());
+        lods.push_back({ 0, indexCount, 0.0f });
+        computeBounds();
     }
 
-    void Draw(Shader& shader) {
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    // Geometry lives in caller-owned memory (e.g. a mapped mesh cache); no CPU copy is kept
+    Mesh(unsigned int vertexCount, unsigned int indexCount,
+        const glm::vec3& boundsMin, const glm::vec3& boundsMax, unsigned int materialIndex) {
+        this->vertexCount = vertexCount;
+        this->indexCount = indexCount;
+        this->boundsMin = boundsMin;
+        this->boundsMax = boundsMax;
+        this->materialIndex = materialIndex;
+        residency = RESIDENCY_RELEASE;
     }
 
-private:
-    unsigned int VBO, EBO;
+    // Move-only: meshes can hold large vertex/index arrays and are never meant to be duplicated
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) noexcept = default;
+    Mesh& operator=(Mesh&&) noexcept = default;
 
-    void setupMesh() {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+    // Appends a simplified level behind the existing ones; needs the full CPU copy
+    void addLod(const std::vector<unsigned int>& lodIndices, float error) {
+        lods.push_back({ indexCount, static_cast<unsigned int>(lodIndices.size()), error });
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        indexCount = static_cast<unsigned int>(indices.size());
+    }
 
-        glBindVertexArray(VAO);
+    glm::vec3 boundsCenter() const {
+        return (boundsMin + boundsMax) * 0.5f;
+    }
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    float boundsRadius() const {
+        return glm::length(boundsMax - boundsMin) * 0.5f;
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    // Replaces the CPU copy with the requested form. Going back up to RESIDENCY_KEEP needs the
+    // full data and therefore goes through restore()
+    void setResidency(GeometryResidency target) {
+        if (target == residency || target == RESIDENCY_KEEP)
+            return;
+        if (target == RESIDENCY_COMPACT && residency == RESIDENCY_KEEP) {
+            quantizePositions();
+            compactIndices.clear();
+            if (vertexCount <= 0xFFFF) {
+                compactIndices.assign(indices.begin(), indices.end());
+                std::vector<unsigned int>().swap(indices);
+            }
+            else {
+                indices.shrink_to_fit();
+            }
+            residency = RESIDENCY_COMPACT;
+        }
+        else if (target == RESIDENCY_RELEASE) {
+            std::vector<unsigned int>().swap(indices);
+            std::vector<uint16_t>().swap(compactPositions);
+            std::vector<uint16_t>().swap(compactIndices);
+            residency = RESIDENCY_RELEASE;
+        }
+        std::vector<Vertex>().swap(vertices);
+    }
 
-        // vertex pos
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // Installs a full CPU copy again, e.g. read back from the mesh cache
+    void restore(std::vector<Vertex> vertices, std::vector<unsigned int> indices) {
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        std::vector<uint16_t>().swap(compactPositions);
+        std::vector<uint16_t>().swap(compactIndices);
+        residency = RESIDENCY_KEEP;
+    }
+
+    bool hasPositions() const {
+        return residency != RESIDENCY_RELEASE && vertexCount > 0;
+    }
 
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    // Position/index accessors that work for both the full and the compact copy
+    glm::vec3 position(unsigned int i) const {
+        if (residency == RESIDENCY_KEEP)
+            return vertices[i].Position;
+        const uint16_t* q = &compactPositions[static_cast<size_t>(i) * 3];
+        glm::vec3 t(q[0], q[1], q[2]);
+        return boundsMin + t * ((boundsMax - boundsMin) / 65535.0f);
+    }
+
+    unsigned int index(unsigned int i) const {
+        if (residency == RESIDENCY_COMPACT && !compactIndices.empty())
+            return compactIndices[i];
+        return indices[i];
+    }
+
+    size_t cpuBytes() const {
+        return vertices.capacity() * sizeof(Vertex) +
+            indices.capacity() * sizeof(unsigned int) +
+            compactPositions.capacity() * sizeof(uint16_t) +
+            compactIndices.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    // RESIDENCY_COMPACT storage: xyz per vertex, and indices narrowed when they fit in 16 bits
+    std::vector<uint16_t> compactPositions;
+    std::vector<uint16_t> compactIndices;
+
+    void quantizePositions() {
+        glm::vec3 extent = boundsMax - boundsMin;
+        glm::vec3 scale(
+            extent.x > 0.0f ? 65535.0f / extent.x : 0.0f,
+            extent.y > 0.0f ? 65535.0f / extent.y : 0.0f,
+            extent.z > 0.0f ? 65535.0f / extent.z : 0.0f);
+        compactPositions.resize(vertices.size() * 3);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            glm::vec3 t = glm::clamp((vertices[i].Position - boundsMin) * scale + 0.5f,
+                glm::vec3(0.0f), glm::vec3(65535.0f));
+            compactPositions[i * 3 + 0] = static_cast<uint16_t>(t.x);
+            compactPositions[i * 3 + 1] = static_cast<uint16_t>(t.y);
+            compactPositions[i * 3 + 2] = static_cast<uint16_t>(t.z);
+        }
+    }
 
-        glBindVertexArray(0);
+    void computeBounds() {
+        boundsMin = glm::vec3(FLT_MAX);
+        boundsMax = glm::vec3(-FLT_MAX);
+        for (const Vertex& v : vertices) {
+            boundsMin = glm::min(boundsMin, v.Position);
+            boundsMax = glm::max(boundsMax, v.Position);
+        }
+        if (vertices.empty()) {
+            boundsMin = boundsMax = glm::vec3(0.0f);
+        }
     }
 };
\ No newline at end of file
@@ -0,0 +1,300 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mesh.h"
+#include "material.h"
+
+// Binary mesh cache written next to the source model after the first Assimp import.
+// Layout: FileHeader, MeshRecord[meshCount], Material[materialCount], then 16-byte aligned
+// vertex/index blobs.
+namespace MeshCache {
+
+    const char kMagic[4] = { 'M', 'S', 'H', 'C' };
+    // Version 2: meshes are stored after MeshOptimizer reordering
+    // Version 3: parts split for 16-bit indices, MeshRecord carries the part index
+    // Version 4: simplified levels of detail follow level 0 in the index blob
+    // Version 5: material table after the mesh records
+    // Version 6: overdraw cluster order no longer costs vertex cache efficiency
+    // Version 7: Tipsify leaves cold fanning candidates to the dead-end stack
+    const uint32_t kVersion = 7;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t meshCount;
+        uint32_t vertexStride;
+        uint32_t materialCount;
+        uint32_t reserved;
+    };
+
+    struct LodRecord {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;
+        uint32_t reserved;
+    };
+
+    struct MeshRecord {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t materialIndex;
+        uint32_t part;
+        float boundsMin[3];
+        float boundsMax[3];
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t lodCount;
+        uint32_t reserved;
+        LodRecord lods[kMaxMeshLods];
+    };
+
+    // Read-only memory mapping of a whole file
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile() { close(); }
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+                close();
+                return false;
+            }
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (!mapping) {
+                close();
+                return false;
+            }
+            bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            length = static_cast<size_t>(fileSize.QuadPart);
+#else
+            fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                close();
+                return false;
+            }
+            void* ptr = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr == MAP_FAILED) {
+                close();
+                return false;
+            }
+            bytes = static_cast<const unsigned char*>(ptr);
+            length = static_cast<size_t>(st.st_size);
+#endif
+            if (!bytes) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (bytes) UnmapViewOfFile(bytes);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = NULL;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+
+        const unsigned char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const unsigned char* bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int fd = -1;
+#endif
+    };
+
+    // 64-bit FNV-1a over the raw bytes of the source model; seed continues an earlier hash
+    inline uint64_t hashBytes(const unsigned char* data, size_t size, uint64_t seed = 14695981039346656037ull) {
+        uint64_t hash = seed;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline bool hashFile(const std::string& path, uint64_t& hash) {
+        MappedFile source;
+        if (!source.open(path))
+            return false;
+        hash = hashBytes(source.data(), source.size());
+        return true;
+    }
+
+    // Folds a companion file (the .mtl of an .obj) into hash; a missing file leaves it unchanged
+    inline void hashCompanion(const std::string& path, uint64_t& hash) {
+        MappedFile companion;
+        if (companion.open(path))
+            hash = hashBytes(companion.data(), companion.size(), hash);
+    }
+
+    inline uint64_t alignUp(uint64_t value) {
+        return (value + 15) & ~uint64_t(15);
+    }
+
+    // Returns the mesh table of a mapped cache, or nullptr if the file is stale or malformed.
+    // materials points at materialCount entries following the mesh table
+    inline const MeshRecord* validate(const MappedFile& cache, uint64_t sourceHash, uint32_t& meshCount,
+        const Material*& materials, uint32_t& materialCount) {
+        if (cache.size() < sizeof(FileHeader))
+            return nullptr;
+
+        const FileHeader* header = reinterpret_cast<const FileHeader*>(cache.data());
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+            header->version != kVersion ||
+            header->sourceHash != sourceHash ||
+            header->vertexStride != sizeof(Vertex))
+            return nullptr;
+
+        uint64_t tableEnd = sizeof(FileHeader) + uint64_t(header->meshCount) * sizeof(MeshRecord) +
+            uint64_t(header->materialCount) * sizeof(Material);
+        if (tableEnd > cache.size())
+            return nullptr;
+
+        const MeshRecord* records = reinterpret_cast<const MeshRecord*>(cache.data() + sizeof(FileHeader));
+        for (uint32_t i = 0; i < header->meshCount; i++) {
+            const MeshRecord& r = records[i];
+            // Splitting only adds meshes, so every part index is below the mesh count
+            if (r.vertexOffset + uint64_t(r.vertexCount) * sizeof(Vertex) > cache.size() ||
+                r.indexOffset + uint64_t(r.indexCount) * sizeof(unsigned int) > cache.size() ||
+                r.lodCount == 0 || r.lodCount > kMaxMeshLods ||
+                r.part >= header->meshCount || r.materialIndex >= header->materialCount)
+                return nullptr;
+            for (uint32_t l = 0; l < r.lodCount; l++) {
+                if (uint64_t(r.lods[l].firstIndex) + r.lods[l].indexCount > r.indexCount)
+                    return nullptr;
+            }
+        }
+
+        meshCount = header->meshCount;
+        materialCount = header->materialCount;
+        materials = reinterpret_cast<const Material*>(records + header->meshCount);
+        return records;
+    }
+
+    inline bool write(const std::string& path, uint64_t sourceHash, const std::vector<Mesh>& meshes,
+        const std::vector<Material>& materials) {
+        FileHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.sourceHash = sourceHash;
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+        header.vertexStride = sizeof(Vertex);
+        header.materialCount = static_cast<uint32_t>(materials.size());
+        header.reserved = 0;
+
+        std::vector<MeshRecord> records(meshes.size());
+        uint64_t offset = alignUp(sizeof(FileHeader) + records.size() * sizeof(MeshRecord) +
+            materials.size() * sizeof(Material));
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const Mesh& mesh = meshes[i];
+            MeshRecord& r = records[i];
+            r.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            r.indexCount = static_cast<uint32_t>(mesh.indices.size());
+            r.materialIndex = mesh.materialIndex;
+            r.part = mesh.part;
+            r.reserved = 0;
+            r.lodCount = static_cast<uint32_t>(std::min(mesh.lods.size(), kMaxMeshLods));
+            std::memset(r.lods, 0, sizeof(r.lods));
+            for (uint32_t l = 0; l < r.lodCount; l++)
+                r.lods[l] = { mesh.lods[l].firstIndex, mesh.lods[l].indexCount, mesh.lods[l].error, 0 };
+            for (int k = 0; k < 3; k++) {
+                r.boundsMin[k] = mesh.boundsMin[k];
+                r.boundsMax[k] = mesh.boundsMax[k];
+            }
+            r.vertexOffset = offset;
+            offset = alignUp(offset + r.vertexCount * sizeof(Vertex));
+            r.indexOffset = offset;
+            offset = alignUp(offset + r.indexCount * sizeof(unsigned int));
+        }
+
+        // Write to a temporary file first so a crash never leaves a truncated cache behind
+        std::string tmpPath = path + ".tmp";
+        FILE* out = std::fopen(tmpPath.c_str(), "wb");
+        if (!out) {
+            std::cerr << "ERROR::MESH_CACHE::CANNOT_WRITE " << tmpPath << std::endl;
+            return false;
+        }
+
+        static const unsigned char padding[16] = {};
+        uint64_t written = 0;
+        auto put = [&](const void* data, size_t size) {
+            if (size && std::fwrite(data, 1, size, out) != size)
+                return false;
+            written += size;
+            return true;
+        };
+        auto padTo = [&](uint64_t target) {
+            return put(padding, static_cast<size_t>(target - written));
+        };
+
+        bool ok = put(&header, sizeof(header)) &&
+            put(records.data(), records.size() * sizeof(MeshRecord)) &&
+            put(materials.data(), materials.size() * sizeof(Material));
+        for (size_t i = 0; ok && i < meshes.size(); i++) {
+            ok = padTo(records[i].vertexOffset) &&
+                put(meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex)) &&
+                padTo(records[i].indexOffset) &&
+                put(meshes[i].indices.data(), meshes[i].indices.size() * sizeof(unsigned int));
+        }
+        ok = (std::fclose(out) == 0) && ok;
+
+        if (ok) {
+            std::remove(path.c_str());
+            ok = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+        }
+        if (!ok) {
+            std::remove(tmpPath.c_str());
+            std::cerr << "ERROR::MESH_CACHE::CANNOT_WRITE " << path << std::endl;
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,386 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Import-time triangle/vertex reordering run on every mesh before it reaches the GeometryArena:
+// exact vertex deduplication, Tipsify post-transform cache ordering (Sander et al. 2007),
+// overdraw-aware cluster sorting and first-use vertex fetch ordering
+namespace MeshOptimizer {
+
+    // FIFO size used both by Tipsify and by the statistics below
+    const unsigned int kCacheSize = 16;
+
+    // Meshes referencing at most this many vertices can be drawn with GL_UNSIGNED_SHORT indices
+    const size_t kMaxShortIndexVertices = 65536;
+
+    // Soft cluster splits may raise a cluster's ACMR up to this factor over the whole mesh
+    const float kOverdrawThreshold = 1.05f;
+    // Cluster cut thresholds optimizeOverdraw tries, from kOverdrawThreshold down in steps
+    const int kOverdrawAttempts = 8;
+    const float kOverdrawCutStep = 0.05f;
+
+    struct CacheStats {
+        float acmr = 0.0f;  // transformed vertices per triangle
+        float atvr = 0.0f;  // transformed vertices per unique vertex
+    };
+
+    struct Stats {
+        size_t verticesBefore = 0;
+        size_t verticesAfter = 0;
+        size_t triangles = 0;
+        CacheStats before;
+        CacheStats after;
+
+        void accumulate(const Stats& other) {
+            auto weigh = [](float a, size_t na, float b, size_t nb) {
+                return na + nb ? (a * na + b * nb) / float(na + nb) : 0.0f;
+            };
+            before.acmr = weigh(before.acmr, triangles, other.before.acmr, other.triangles);
+            after.acmr = weigh(after.acmr, triangles, other.after.acmr, other.triangles);
+            before.atvr = weigh(before.atvr, verticesBefore, other.before.atvr, other.verticesBefore);
+            after.atvr = weigh(after.atvr, verticesAfter, other.after.atvr, other.verticesAfter);
+            verticesBefore += other.verticesBefore;
+            verticesAfter += other.verticesAfter;
+            triangles += other.triangles;
+        }
+    };
+
+    // Simulates a FIFO post-transform cache over the index stream
+    inline CacheStats analyzeCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+        unsigned int cacheSize = kCacheSize) {
+        CacheStats stats;
+        if (indices.empty() || vertexCount == 0)
+            return stats;
+
+        std::vector<unsigned int> insertedAt(vertexCount, 0);
+        unsigned int timestamp = cacheSize + 1;
+        size_t misses = 0;
+        for (unsigned int v : indices) {
+            if (timestamp - insertedAt[v] > cacheSize) {
+                insertedAt[v] = timestamp++;
+                misses++;
+            }
+        }
+        stats.acmr = float(misses) / float(indices.size() / 3);
+        stats.atvr = float(misses) / float(vertexCount);
+        return stats;
+    }
+
+    // Merges bitwise-identical vertices and rewrites the index buffer accordingly
+    inline void deduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+        struct VertexHash {
+            size_t operator()(const Vertex& v) const {
+                uint32_t words[6];
+                std::memcpy(words, &v, sizeof(words));
+                uint64_t h = 14695981039346656037ull;
+                for (uint32_t w : words) {
+                    h ^= w;
+                    h *= 1099511628211ull;
+                }
+                return static_cast<size_t>(h);
+            }
+        };
+        struct VertexEqual {
+            bool operator()(const Vertex& a, const Vertex& b) const {
+                return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+            }
+        };
+        static_assert(sizeof(Vertex) == 6 * sizeof(uint32_t), "Vertex hash expects six floats");
+
+        std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+        unique.reserve(vertices.size());
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<Vertex> merged;
+        merged.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            auto inserted = unique.emplace(vertices[i], static_cast<unsigned int>(merged.size()));
+            if (inserted.second)
+                merged.push_back(vertices[i]);
+            remap[i] = inserted.first->second;
+        }
+        for (unsigned int& index : indices)
+            index = remap[index];
+        vertices.swap(merged);
+    }
+
+    // Tipsify: fans around the most recently cached vertex that still has triangles left.
+    // clusterStarts receives the first triangle after every dead end, where the cache is cold
+    inline void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+        std::vector<unsigned int>& clusterStarts, unsigned int cacheSize = kCacheSize) {
+        size_t triangleCount = indices.size() / 3;
+        clusterStarts.clear();
+        if (triangleCount == 0)
+            return;
+
+        // Vertex -> triangle adjacency in CSR form
+        std::vector<unsigned int> live(vertexCount, 0);
+        for (unsigned int v : indices)
+            live[v]++;
+        std::vector<unsigned int> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+        std::vector<unsigned int> adjacency(indices.size());
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        std::vector<unsigned int> cacheTime(vertexCount, 0);
+        std::vector<char> emitted(triangleCount, 0);
+        std::vector<unsigned int> deadEnd;
+        std::vector<unsigned int> candidates;
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        unsigned int timestamp = cacheSize + 1;
+        size_t cursor = 0;
+
+        auto skipDeadEnd = [&]() -> long long {
+            while (!deadEnd.empty()) {
+                unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] > 0)
+                    return v;
+            }
+            while (cursor < vertexCount) {
+                if (live[cursor] > 0)
+                    return static_cast<long long>(cursor);
+                cursor++;
+            }
+            return -1;
+        };
+
+        clusterStarts.push_back(0);
+        long long fan = skipDeadEnd();
+        while (fan >= 0) {
+            candidates.clear();
+            for (unsigned int a = offsets[fan]; a < offsets[fan + 1]; a++) {
+                unsigned int t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                for (int k = 0; k < 3; k++) {
+                    unsigned int v = indices[t * 3 + k];
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (timestamp - cacheTime[v] > cacheSize)
+                        cacheTime[v] = timestamp++;
+                }
+                emitted[t] = 1;
+            }
+
+            // Prefer a candidate that will still be cached after its remaining fan is emitted;
+            // one that will not (priority 0) loses to the dead-end stack, as in the paper
+            long long next = -1;
+            int best = 0;
+            for (unsigned int v : candidates) {
+                if (live[v] == 0)
+                    continue;
+                int priority = 0;
+                if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize)
+                    priority = static_cast<int>(timestamp - cacheTime[v]);
+                if (priority > best) {
+                    best = priority;
+                    next = v;
+                }
+            }
+            if (next < 0) {
+                next = skipDeadEnd();
+                if (next >= 0 && result.size() < indices.size())
+                    clusterStarts.push_back(static_cast<unsigned int>(result.size() / 3));
+            }
+            fan = next;
+        }
+        indices.swap(result);
+    }
+
+    // Cluster starts for optimizeOverdraw: every Tipsify cluster, split further as soon as a
+    // cluster's own ACMR drops to cutAcmr. Every cluster, hard or soft, is simulated from an
+    // empty cache, since it may end up drawn after any other one
+    inline std::vector<unsigned int> overdrawClusters(const std::vector<unsigned int>& indices, size_t vertexCount,
+        const std::vector<unsigned int>& hardStarts, float cutAcmr, unsigned int cacheSize) {
+        size_t triangleCount = indices.size() / 3;
+        std::vector<unsigned int> starts;
+        std::vector<unsigned int> insertedAt(vertexCount, 0);
+        unsigned int timestamp = cacheSize + 1;
+        size_t hard = 0;
+        size_t clusterMisses = 0, clusterTriangles = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            bool hardStart = hard < hardStarts.size() && hardStarts[hard] == t;
+            if (hardStart)
+                hard++;
+            if (hardStart || (clusterTriangles > 0 && clusterMisses <= cutAcmr * clusterTriangles)) {
+                starts.push_back(static_cast<unsigned int>(t));
+                clusterMisses = clusterTriangles = 0;
+                timestamp += cacheSize + 1;
+            }
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                if (timestamp - insertedAt[v] > cacheSize) {
+                    insertedAt[v] = timestamp++;
+                    clusterMisses++;
+                }
+            }
+            clusterTriangles++;
+        }
+        starts.push_back(static_cast<unsigned int>(triangleCount));
+        return starts;
+    }
+
+    // Orders clusters so that outward-facing ones far from the centre draw first and occlude the rest
+    inline std::vector<unsigned int> sortClusters(const std::vector<unsigned int>& indices,
+        const std::vector<Vertex>& vertices, const std::vector<unsigned int>& starts) {
+        glm::vec3 meshCentroid(0.0f);
+        for (const Vertex& v : vertices)
+            meshCentroid += v.Position;
+        if (!vertices.empty())
+            meshCentroid /= float(vertices.size());
+
+        size_t clusterCount = starts.size() - 1;
+        std::vector<float> sortKey(clusterCount, 0.0f);
+        for (size_t c = 0; c < clusterCount; c++) {
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (unsigned int t = starts[c]; t < starts[c + 1]; t++) {
+                const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float a = glm::length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            if (area > 0.0f)
+                centroid /= area;
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                sortKey[c] = glm::dot(centroid - meshCentroid, normal / length);
+        }
+
+        std::vector<unsigned int> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(),
+            [&sortKey](unsigned int a, unsigned int b) { return sortKey[a] > sortKey[b]; });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (unsigned int c : order)
+            result.insert(result.end(), indices.begin() + starts[c] * 3, indices.begin() + starts[c + 1] * 3);
+        return result;
+    }
+
+    // Splits the Tipsify clusters further wherever the cache cost allows, then sorts the clusters
+    // for overdraw. The result never exceeds threshold times the Tipsify ACMR: cold-started
+    // clusters cost more than the cut test can see, so the cut is tightened while the sorted
+    // order is over that limit, and the Tipsify order is kept if no attempt fits
+    inline void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices,
+        const std::vector<unsigned int>& hardStarts, float threshold = kOverdrawThreshold,
+        unsigned int cacheSize = kCacheSize) {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || hardStarts.empty())
+            return;
+
+        float meshAcmr = analyzeCache(indices, vertices.size(), cacheSize).acmr;
+        float limit = threshold * meshAcmr;
+        float cut = threshold;
+        for (int attempt = 0; attempt < kOverdrawAttempts; attempt++, cut -= kOverdrawCutStep) {
+            std::vector<unsigned int> starts = overdrawClusters(indices, vertices.size(), hardStarts, cut * meshAcmr, cacheSize);
+            std::vector<unsigned int> sorted = sortClusters(indices, vertices, starts);
+            if (analyzeCache(sorted, vertices.size(), cacheSize).acmr <= limit) {
+                indices.swap(sorted);
+                return;
+            }
+        }
+    }
+
+    // Renumbers vertices in order of first use so fetches walk the vertex buffer linearly;
+    // vertices no triangle references are dropped
+    inline void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+        const unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (unsigned int& index : indices) {
+            if (remap[index] == unused) {
+                remap[index] = static_cast<unsigned int>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+
+    struct MeshPiece {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+    };
+
+    // Cuts a triangle list into consecutive pieces that each reference at most maxVertices
+    // vertices, with indices local to the piece. Triangle order is kept, so the cache and
+    // overdraw ordering survive; vertices on a cut are duplicated into both pieces
+    inline std::vector<MeshPiece> splitForIndexRange(std::vector<Vertex>&& vertices, std::vector<unsigned int>&& indices,
+        size_t maxVertices = kMaxShortIndexVertices) {
+        std::vector<MeshPiece> pieces;
+        if (vertices.size() <= maxVertices) {
+            pieces.push_back({ std::move(vertices), std::move(indices) });
+            return pieces;
+        }
+
+        const unsigned int none = ~0u;
+        std::vector<unsigned int> owner(vertices.size(), none);
+        std::vector<unsigned int> local(vertices.size(), 0);
+        pieces.emplace_back();
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            unsigned int piece = static_cast<unsigned int>(pieces.size() - 1);
+            size_t added = 0;
+            for (int k = 0; k < 3; k++)
+                added += owner[indices[t + k]] != piece;
+            if (pieces.back().vertices.size() + added > maxVertices) {
+                pieces.emplace_back();
+                piece++;
+            }
+            MeshPiece& current = pieces.back();
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t + k];
+                if (owner[v] != piece) {
+                    owner[v] = piece;
+                    local[v] = static_cast<unsigned int>(current.vertices.size());
+                    current.vertices.push_back(vertices[v]);
+                }
+                current.indices.push_back(local[v]);
+            }
+        }
+        return pieces;
+    }
+
+    // Full pipeline; indices must be a triangle list
+    inline Stats optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+        Stats stats;
+        stats.verticesBefore = vertices.size();
+        stats.triangles = indices.size() / 3;
+        stats.before = analyzeCache(indices, vertices.size());
+
+        deduplicateVertices(vertices, indices);
+        std::vector<unsigned int> clusterStarts;
+        optimizeVertexCache(indices, vertices.size(), clusterStarts);
+        float tipsifyAcmr = analyzeCache(indices, vertices.size()).acmr;
+        optimizeOverdraw(indices, vertices, clusterStarts);
+        assert(analyzeCache(indices, vertices.size()).acmr <= kOverdrawThreshold * tipsifyAcmr);
+        (void)tipsifyAcmr;
+        optimizeVertexFetch(vertices, indices);
+
+        stats.verticesAfter = vertices.size();
+        stats.after = analyzeCache(indices, vertices.size());
+        return stats;
+    }
+}
\ No newline at end of file
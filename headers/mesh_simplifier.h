@@ -0,0 +1,349 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+// Import-time LOD generation by quadric edge collapse (Garland & Heckbert 1997). Collapses
+// only move a vertex onto one of its neighbours, so every level indexes the original vertex
+// buffer and all levels of a mesh share one vertex range in the GeometryArena
+namespace MeshSimplifier {
+
+    // Each level aims for this fraction of the previous level's triangles
+    const float kLevelRatio = 0.5f;
+
+    // Meshes below this many triangles are not simplified
+    const size_t kMinTriangles = 32;
+
+    // A level that removes less than this fraction of triangles ends the chain
+    const float kMinReduction = 0.1f;
+
+    // Boundary edges are held in place by planes weighted this much more than surface planes
+    const double kBoundaryWeight = 10.0;
+
+    struct Level {
+        std::vector<unsigned int> indices;
+        float error;  // largest collapse error so far, in model units
+    };
+
+    // Symmetric 4x4 plane quadric plus the accumulated weight used to normalize its cost
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        static Quadric plane(const glm::dvec3& n, double d, double w) {
+            Quadric q;
+            q.a00 = w * n.x * n.x; q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z; q.a03 = w * n.x * d;
+            q.a11 = w * n.y * n.y; q.a12 = w * n.y * n.z; q.a13 = w * n.y * d;
+            q.a22 = w * n.z * n.z; q.a23 = w * n.z * d;
+            q.a33 = w * d * d;
+            q.weight = w;
+            return q;
+        }
+
+        void add(const Quadric& o) {
+            a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+            a11 += o.a11; a12 += o.a12; a13 += o.a13;
+            a22 += o.a22; a23 += o.a23;
+            a33 += o.a33;
+            weight += o.weight;
+        }
+
+        // Weighted mean squared distance of p to the accumulated planes
+        double error(const glm::dvec3& p) const {
+            double e = a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + 2 * a03 * p.x
+                + a11 * p.y * p.y + 2 * a12 * p.y * p.z + 2 * a13 * p.y
+                + a22 * p.z * p.z + 2 * a23 * p.z
+                + a33;
+            return weight > 0 ? std::fabs(e) / weight : 0.0;
+        }
+    };
+
+    // Collapse state over position-welded vertices; attribute seams are resolved when a level
+    // is written out
+    class Simplifier {
+    public:
+        Simplifier(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+            : vertices(vertices) {
+            weld(indices);
+            buildQuadrics();
+        }
+
+        size_t triangleCount() const {
+            return triangles.size() / 3;
+        }
+
+        float error() const {
+            return maxError;
+        }
+
+        // Collapses edges in cheapest-first passes until the target is met or nothing collapses
+        void reduceTo(size_t targetTriangles) {
+            while (triangleCount() > targetTriangles) {
+                if (!collapsePass(triangleCount() - targetTriangles))
+                    break;
+            }
+        }
+
+        // Current triangles as original vertex indices: each corner takes the vertex at that
+        // position whose normal best matches the face, which keeps hard edges hard
+        std::vector<unsigned int> indices() const {
+            std::vector<unsigned int> result;
+            result.reserve(triangles.size());
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                glm::vec3 n = faceNormal(triangles[t], triangles[t + 1], triangles[t + 2]);
+                for (int k = 0; k < 3; k++) {
+                    unsigned int w = triangles[t + k];
+                    unsigned int best = corners[cornerOffsets[w]];
+                    float bestDot = -2.0f;
+                    for (unsigned int c = cornerOffsets[w]; c < cornerOffsets[w + 1]; c++) {
+                        float d = glm::dot(vertices[corners[c]].Normal, n);
+                        if (d > bestDot) {
+                            bestDot = d;
+                            best = corners[c];
+                        }
+                    }
+                    result.push_back(best);
+                }
+            }
+            return result;
+        }
+
+    private:
+        const std::vector<Vertex>& vertices;
+        std::vector<glm::vec3> positions;            // per welded vertex
+        std::vector<unsigned int> cornerOffsets;     // welded vertex -> range in corners
+        std::vector<unsigned int> corners;           // original vertices sharing a position
+        std::vector<unsigned int> triangles;         // welded indices
+        std::vector<Quadric> quadrics;
+        float maxError = 0.0f;
+
+        void weld(const std::vector<unsigned int>& indices) {
+            struct PositionHash {
+                size_t operator()(const glm::vec3& p) const {
+                    uint32_t words[3];
+                    std::memcpy(words, &p, sizeof(words));
+                    return (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+                }
+            };
+            std::unordered_map<glm::vec3, unsigned int, PositionHash> unique;
+            unique.reserve(vertices.size());
+            std::vector<unsigned int> welded(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++) {
+                auto inserted = unique.emplace(vertices[i].Position, static_cast<unsigned int>(positions.size()));
+                if (inserted.second)
+                    positions.push_back(vertices[i].Position);
+                welded[i] = inserted.first->second;
+            }
+
+            cornerOffsets.assign(positions.size() + 1, 0);
+            for (unsigned int w : welded)
+                cornerOffsets[w + 1]++;
+            for (size_t w = 0; w < positions.size(); w++)
+                cornerOffsets[w + 1] += cornerOffsets[w];
+            corners.resize(vertices.size());
+            std::vector<unsigned int> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+            for (size_t i = 0; i < vertices.size(); i++)
+                corners[fill[welded[i]]++] = static_cast<unsigned int>(i);
+
+            triangles.reserve(indices.size());
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                unsigned int a = welded[indices[t]], b = welded[indices[t + 1]], c = welded[indices[t + 2]];
+                if (a != b && b != c && a != c) {
+                    triangles.push_back(a);
+                    triangles.push_back(b);
+                    triangles.push_back(c);
+                }
+            }
+        }
+
+        glm::vec3 faceNormal(unsigned int a, unsigned int b, unsigned int c) const {
+            glm::vec3 n = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+            float length = glm::length(n);
+            return length > 0.0f ? n / length : glm::vec3(0.0f);
+        }
+
+        void buildQuadrics() {
+            quadrics.assign(positions.size(), Quadric());
+
+            // Edge -> number of triangles using it, to find open boundaries
+            std::unordered_map<uint64_t, int> edgeUse;
+            auto edgeKey = [](unsigned int a, unsigned int b) {
+                return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+            };
+            for (size_t t = 0; t < triangles.size(); t += 3)
+                for (int k = 0; k < 3; k++)
+                    edgeUse[edgeKey(triangles[t + k], triangles[t + (k + 1) % 3])]++;
+
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                glm::dvec3 p0 = positions[triangles[t]];
+                glm::dvec3 p1 = positions[triangles[t + 1]];
+                glm::dvec3 p2 = positions[triangles[t + 2]];
+                glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+                double area2 = glm::length(n);
+                if (area2 <= 0.0)
+                    continue;
+                n /= area2;
+                Quadric q = Quadric::plane(n, -glm::dot(n, p0), area2 * 0.5);
+                for (int k = 0; k < 3; k++)
+                    quadrics[triangles[t + k]].add(q);
+
+                for (int k = 0; k < 3; k++) {
+                    unsigned int a = triangles[t + k], b = triangles[t + (k + 1) % 3];
+                    if (edgeUse[edgeKey(a, b)] != 1)
+                        continue;
+                    glm::dvec3 edge = glm::dvec3(positions[b]) - glm::dvec3(positions[a]);
+                    glm::dvec3 side = glm::cross(edge, n);
+                    double length = glm::length(side);
+                    if (length <= 0.0)
+                        continue;
+                    side /= length;
+                    Quadric boundary = Quadric::plane(side, -glm::dot(side, glm::dvec3(positions[a])),
+                        kBoundaryWeight * glm::dot(edge, edge));
+                    quadrics[a].add(boundary);
+                    quadrics[b].add(boundary);
+                }
+            }
+        }
+
+        // Moving `from` onto `to` must not flip or collapse any surviving triangle around `from`
+        bool flips(unsigned int from, unsigned int to,
+            const std::vector<unsigned int>& adjacencyOffsets, const std::vector<unsigned int>& adjacency) const {
+            for (unsigned int i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; i++) {
+                size_t t = size_t(adjacency[i]) * 3;
+                unsigned int v[3] = { triangles[t], triangles[t + 1], triangles[t + 2] };
+                if (v[0] == to || v[1] == to || v[2] == to)
+                    continue;
+                glm::vec3 before = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+                for (unsigned int& w : v)
+                    if (w == from) w = to;
+                glm::vec3 after = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+                if (glm::dot(before, after) <= 0.0f)
+                    return true;
+            }
+            return false;
+        }
+
+        bool collapsePass(size_t excessTriangles) {
+            size_t vertexCount = positions.size();
+            size_t triCount = triangleCount();
+
+            std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+            for (unsigned int w : triangles)
+                adjacencyOffsets[w + 1]++;
+            for (size_t v = 0; v < vertexCount; v++)
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            std::vector<unsigned int> adjacency(triangles.size());
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t t = 0; t < triCount; t++)
+                for (int k = 0; k < 3; k++)
+                    adjacency[fill[triangles[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+            struct Collapse {
+                unsigned int from, to;
+                double cost;
+            };
+            std::vector<uint64_t> edges;
+            edges.reserve(triangles.size());
+            for (size_t t = 0; t < triCount; t++) {
+                for (int k = 0; k < 3; k++) {
+                    unsigned int a = triangles[t * 3 + k], b = triangles[t * 3 + (k + 1) % 3];
+                    edges.push_back(a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a);
+                }
+            }
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            // Cost of a collapse is the merged quadric evaluated at the surviving position
+            std::vector<Collapse> candidates;
+            candidates.reserve(edges.size());
+            for (uint64_t edge : edges) {
+                unsigned int a = static_cast<unsigned int>(edge >> 32), b = static_cast<unsigned int>(edge);
+                Quadric merged = quadrics[a];
+                merged.add(quadrics[b]);
+                double ab = merged.error(positions[b]);
+                double ba = merged.error(positions[a]);
+                candidates.push_back(ab <= ba ? Collapse{ a, b, ab } : Collapse{ b, a, ba });
+            }
+            std::sort(candidates.begin(), candidates.end(),
+                [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            // Each collapse removes about two triangles; vertices touched by one collapse are
+            // locked for the rest of the pass so the flip test stays valid
+            std::vector<unsigned int> remap(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++)
+                remap[v] = static_cast<unsigned int>(v);
+            std::vector<char> locked(vertexCount, 0);
+            size_t budget = excessTriangles / 2 + 1;
+            size_t collapsed = 0;
+            for (const Collapse& c : candidates) {
+                if (collapsed >= budget)
+                    break;
+                if (locked[c.from] || locked[c.to])
+                    continue;
+                if (flips(c.from, c.to, adjacencyOffsets, adjacency))
+                    continue;
+
+                remap[c.from] = c.to;
+                quadrics[c.to].add(quadrics[c.from]);
+                maxError = std::max(maxError, static_cast<float>(std::sqrt(c.cost)));
+                for (unsigned int v : { c.from, c.to })
+                    for (unsigned int i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; i++)
+                        for (int k = 0; k < 3; k++)
+                            locked[triangles[size_t(adjacency[i]) * 3 + k]] = 1;
+                collapsed++;
+            }
+            if (collapsed == 0)
+                return false;
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                unsigned int a = remap[triangles[t]], b = remap[triangles[t + 1]], c = remap[triangles[t + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+                triangles[write++] = a;
+                triangles[write++] = b;
+                triangles[write++] = c;
+            }
+            triangles.resize(write);
+            return true;
+        }
+    };
+
+    // Levels 1..maxLevels-1 of a mesh (level 0 is the input itself), each with about
+    // kLevelRatio of the previous level's triangles and ordered for the post-transform cache
+    inline std::vector<Level> generateLods(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        size_t maxLevels) {
+        std::vector<Level> levels;
+        if (indices.size() / 3 < kMinTriangles || maxLevels < 2)
+            return levels;
+
+        Simplifier simplifier(vertices, indices);
+        size_t previous = indices.size() / 3;
+        std::vector<unsigned int> clusterStarts;
+        while (levels.size() + 1 < maxLevels && previous >= kMinTriangles) {
+            simplifier.reduceTo(static_cast<size_t>(previous * kLevelRatio));
+            size_t reached = simplifier.triangleCount();
+            if (reached == 0 || reached > previous * (1.0f - kMinReduction))
+                break;
+
+            Level level;
+            level.indices = simplifier.indices();
+            level.error = simplifier.error();
+            MeshOptimizer::optimizeVertexCache(level.indices, vertices.size(), clusterStarts);
+            levels.push_back(std::move(level));
+            previous = reached;
+        }
+        return levels;
+    }
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <algorithm>
+#include <utility>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -10,86 +12,626 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "mesh.h"
+#include "geometry_arena.h"
+#include "indirect_draw.h"
+#include "robot_instances.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "lod.h"
+#include "frustum.h"
+#include "gpu_culling.h"
+#include "material.h"
+#include "gl_state.h"
 #include "shader.h"
 
 class Model {
 public:
+    // One entry per draw; a part split for 16-bit indices contributes several meshes
     std::vector<Mesh> meshes;
+    // One model matrix per part (Mesh::part), which is also the joint index
     std::vector<glm::mat4> meshTransforms;
+    size_t partCount = 0;
+    GeometryArena geometry;
+    IndirectDrawBuffer drawCommands;
     std::string directory;
+    // Imported materials, indexed by Mesh::materialIndex; a single fallback when the file has none
+    std::vector<Material> materials;
 
-    Model(std::string const& path) {
+    // Post-transform cache statistics of the last Assimp import; zero after a warm cache load
+    MeshOptimizer::Stats importStats;
+
+    // residency decides what stays in system memory after the upload; see GeometryResidency.
+    // VERTEX_FORMAT_PACKED halves the vertex buffer and needs shaders built with PACKED_VERTICES
+    Model(std::string const& path, GeometryResidency residency = RESIDENCY_KEEP,
+        VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT) {
+        this->residency = residency;
+        this->vertexFormat = vertexFormat;
         loadModel(path);
-        meshTransforms.resize(meshes.size(), glm::mat4(1.0f));
+        resolveMaterials();
+        for (const Mesh& mesh : meshes)
+            partCount = std::max(partCount, static_cast<size_t>(mesh.part) + 1);
+        meshTransforms.resize(partCount, glm::mat4(1.0f));
+        partTransforms.resize(partCount, PartTransform::from(glm::mat4(1.0f)));
+        dirtyBegin = 0;
+        dirtyEnd = meshTransforms.size();
+        computeBoundingSphere();
+        drawCommands.create(partCount, geometry.indexType);
     }
 
+    // Uploads the changed meshTransforms and renders every visible mesh with a single
+    // glMultiDrawElementsIndirect; the vertex shader picks its part's model matrix via gl_DrawID.
+    // Bindings go through GLStateCache and stay bound, so back-to-back draws sharing the
+    // program, arena or tables do not re-issue them
     void Draw(Shader& shader) {
-        for (size_t i = 0; i < meshes.size(); i++) {
-            shader.setMat4("model", meshTransforms[i]);
-            meshes[i].Draw(shader);
+        UploadTransforms();
+        if (!drawsPrepared || preparedInstances)
+            PrepareDraws();
+        shader.use();
+        geometry.bindDequant();
+        materialTable.bind();
+
+        GLStateCache::current().bindVertexArray(geometry.VAO);
+        drawCommands.draw();
+        drawsPrepared = false;
+    }
+
+    // Draws every instance of the buffer with the same indirect call; shaders/instanced.vert
+    // composes each mesh's kinematic chain from the per-instance joint angles
+    void DrawInstanced(Shader& shader, const RobotInstanceBuffer& instances) {
+        if (instances.instanceCount == 0)
+            return;
+        if (!drawsPrepared || preparedInstances != &instances)
+            PrepareDraws(&instances);
+        shader.use();
+        instances.bind();
+        geometry.bindDequant();
+        materialTable.bind();
+
+        GLStateCache::current().bindVertexArray(geometry.VAO);
+        drawCommands.submit();
+        drawsPrepared = false;
+    }
+
+    // Draws every visible instance from the lists culler builds on the GPU; neither PrepareDraws
+    // nor SetInstanceBounds is needed, the culler poses the meshes from the joint angles itself.
+    // With occlusion culling the robots visible last frame are drawn first and the rest is
+    // tested against the depth they leave, so the target framebuffer must be bound for reading
+    void DrawCulled(Shader& shader, const RobotInstanceBuffer& instances, GpuCuller& culler) {
+        if (instances.instanceCount == 0)
+            return;
+        instances.bind();
+        geometry.bindDequant();
+        materialTable.bind();
+        GLStateCache::current().bindVertexArray(geometry.VAO);
+
+        culler.cull(GpuCuller::PHASE_VISIBLE);
+        shader.use();
+        culler.submit(GpuCuller::PHASE_VISIBLE, geometry.indexType);
+        if (culler.occlusionEnabled()) {
+            culler.cull(GpuCuller::PHASE_DISOCCLUDED);
+            shader.use();
+            culler.submit(GpuCuller::PHASE_DISOCCLUDED, geometry.indexType);
+        }
+    }
+
+    // Material table the draws of this model read; part of its render queue sort key
+    GLuint MaterialBuffer() const {
+        return materialTable.buffer;
+    }
+
+    // Center of the rest-pose bounding sphere, for depth sorting
+    glm::vec3 BoundingCenter() const {
+        return sphereCenter;
+    }
+
+    // Camera used by PrepareDraws to pick levels of detail; the default view always draws level 0
+    void SetLodView(const LodView& view) {
+        lodView = view;
+    }
+
+    // Frustum PrepareDraws culls meshes against; the default frustum culls nothing
+    void SetFrustum(const Frustum& view) {
+        frustum = view;
+    }
+
+    // Posed bounds of every mesh of every robot for culling and LOD of instanced draws.
+    // partTransforms[i * partStride + p] is the model-space matrix of part p of robot i (as
+    // BatchFK produces it with partStride = jointCount()); the robot's placement is added here.
+    // Parts without a matrix stay in the rest pose, as in shaders/instanced.vert. Call it when
+    // the angles change
+    void SetInstanceBounds(const RobotInstanceBuffer& instances, const glm::mat4* partTransforms, size_t partStride) {
+        size_t count = instances.placements.size();
+        const glm::mat4 restPose(1.0f);
+        instanceSpheres.resize(meshes.size() * count);
+        for (size_t m = 0; m < meshes.size(); m++) {
+            const Mesh& mesh = meshes[m];
+            glm::vec4 center = glm::vec4(mesh.boundsCenter(), 1.0f);
+            float radius = mesh.boundsRadius();
+            bool posed = mesh.part < partStride;
+            for (size_t i = 0; i < count; i++) {
+                const glm::mat4& transform = posed ? partTransforms[i * partStride + mesh.part] : restPose;
+                glm::vec3 world = glm::vec3(transform * center) + glm::vec3(instances.placements[i].origin);
+                instanceSpheres.set(m * count + i, world, radius * maxAxisScale(transform));
+            }
+        }
+        instanceBoundsCount = count;
+    }
+
+    // Picks a level of detail per mesh (and per robot when instances are given), drops meshes
+    // outside the frustum and writes the resulting draw list into the ring.
+    // Draw/DrawInstanced call it themselves when the frame has not prepared its draws yet
+    void PrepareDraws(const RobotInstanceBuffer* instances = nullptr, PersistentRingBuffer* ring = nullptr) {
+        drawList.clear();
+        recordList.clear();
+        culledDraws = 0;
+        if (instances)
+            buildInstancedDraws(*instances, ring);
+        else
+            buildSingleDraws();
+        drawCommands.setDraws(drawList, recordList, ring);
+        drawsPrepared = true;
+        preparedInstances = instances;
+    }
+
+    // Triangles the last prepared draw list submits, summed over instances
+    size_t PreparedTriangles() const {
+        size_t triangles = 0;
+        for (const DrawElementsIndirectCommand& command : drawList)
+            triangles += size_t(command.count / 3) * command.instanceCount;
+        return triangles;
+    }
+
+    // Mesh draws (counted per instance) the last PrepareDraws dropped by frustum culling
+    size_t CulledDraws() const {
+        return culledDraws;
+    }
+
+    // Pushes transforms changed since the last upload to the GPU, through the ring when one is
+    // given; Draw calls it as well
+    void UploadTransforms(PersistentRingBuffer* ring = nullptr) {
+        if (dirtyBegin < dirtyEnd) {
+            drawCommands.setTransforms(partTransforms, dirtyBegin, dirtyEnd - dirtyBegin, ring);
+            dirtyBegin = meshTransforms.size();
+            dirtyEnd = 0;
+        }
+    }
+
+    void UpdateTransform(size_t partIndex, const glm::mat4& transform) {
+        if (partIndex < meshTransforms.size()) {
+            meshTransforms[partIndex] = transform;
+            partTransforms[partIndex] = PartTransform::from(transform);
+            dirtyBegin = std::min(dirtyBegin, partIndex);
+            dirtyEnd = std::max(dirtyEnd, partIndex + 1);
         }
     }
 
-    void UpdateTransform(size_t meshIndex, const glm::mat4& transform) {
-        if (meshIndex < meshTransforms.size()) {
-            meshTransforms[meshIndex] = transform;
+    // Switches every mesh to another residency. Anything above the current level is rebuilt
+    // from a rehydrated full copy
+    void SetResidency(GeometryResidency target) {
+        residency = target;
+        if (target != RESIDENCY_RELEASE && !Rehydrate())
+            return;
+        for (Mesh& mesh : meshes) {
+            mesh.setResidency(target);
         }
     }
 
+    // Restores full CPU copies of meshes that were compacted or released. Reads the mapped mesh
+    // cache and only falls back to a new Assimp import when the cache is gone or stale
+    bool Rehydrate() {
+        bool needed = false;
+        for (const Mesh& mesh : meshes)
+            needed = needed || mesh.residency != RESIDENCY_KEEP;
+        if (!needed)
+            return true;
+
+        if (rehydrateFromCache())
+            return true;
+
+        Assimp::Importer importer;
+        const aiScene* scene = importScene(importer, sourcePath);
+        if (!scene)
+            return false;
+        std::vector<Mesh> imported;
+        imported.reserve(scene->mNumMeshes);
+        MeshOptimizer::Stats stats;
+        processNode(scene->mRootNode, scene, imported, stats);
+        if (imported.size() != meshes.size()) {
+            std::cerr << "ERROR::MODEL::REHYDRATE_MISMATCH " << sourcePath << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < meshes.size(); i++) {
+            if (meshes[i].residency != RESIDENCY_KEEP)
+                meshes[i].restore(std::move(imported[i].vertices), std::move(imported[i].indices));
+        }
+        return true;
+    }
+
+    // System memory held by CPU-side mesh geometry
+    size_t CpuGeometryBytes() const {
+        size_t bytes = 0;
+        for (const Mesh& mesh : meshes)
+            bytes += mesh.cpuBytes();
+        return bytes;
+    }
+
 private:
+    GeometryResidency residency = RESIDENCY_KEEP;
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    std::string sourcePath;
+    std::string cachePath;
+    uint64_t sourceHash = 0;
+
+    MaterialTable materialTable;
+    // Mesh indices ordered by (material, part), the order draw lists are built in
+    std::vector<size_t> drawOrder;
+
+    // GPU layout of meshTransforms with the normal matrices alongside
+    std::vector<PartTransform> partTransforms;
+
+    // Range of meshTransforms changed through UpdateTransform since the last upload
+    size_t dirtyBegin = 0;
+    size_t dirtyEnd = 0;
+
+    // Level-of-detail selection state
+    LodView lodView;
+    glm::vec3 sphereCenter = glm::vec3(0.0f);
+    float sphereRadius = 0.0f;
+    bool drawsPrepared = false;
+    const RobotInstanceBuffer* preparedInstances = nullptr;
+    std::vector<DrawElementsIndirectCommand> drawList;
+    std::vector<DrawRecord> recordList;
+    std::vector<GLuint> instanceList;
+    std::vector<float> instanceDistances;
+    std::vector<GLuint> lodBuckets[kMaxMeshLods];
+
+    // Frustum culling state: world spheres of the single robot's meshes, and posed spheres of
+    // every mesh of every robot stored mesh-major ([m * instanceBoundsCount + i])
+    Frustum frustum;
+    SphereCuller culler;
+    SphereSet meshSpheres;
+    SphereSet instanceSpheres;
+    size_t instanceBoundsCount = 0;
+    std::vector<uint8_t> visibility;
+    size_t culledDraws = 0;
+
+    void computeBoundingSphere() {
+        if (meshes.empty())
+            return;
+        glm::vec3 lo = meshes[0].boundsMin, hi = meshes[0].boundsMax;
+        for (const Mesh& mesh : meshes) {
+            lo = glm::min(lo, mesh.boundsMin);
+            hi = glm::max(hi, mesh.boundsMax);
+        }
+        sphereCenter = (lo + hi) * 0.5f;
+        sphereRadius = glm::length(hi - lo) * 0.5f;
+    }
+
+    void addDraw(const Mesh& mesh, size_t meshIndex, unsigned int level, GLuint instanceCount, GLuint baseInstance) {
+        const MeshLod& lod = mesh.lods[level];
+        drawList.push_back({ lod.indexCount, instanceCount, mesh.firstIndex + lod.firstIndex, mesh.baseVertex, baseInstance });
+        recordList.push_back({ mesh.part, static_cast<GLuint>(meshIndex), mesh.materialIndex });
+    }
+
+    // One draw per visible mesh, in drawOrder like every draw list. Bounding spheres moved by the
+    // part transforms are culled in one batch, survivors are checked again with their transformed
+    // boxes; the LOD distance is taken to the same sphere
+    void buildSingleDraws() {
+        meshSpheres.resize(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++) {
+            const Mesh& mesh = meshes[m];
+            const glm::mat4& transform = meshTransforms[mesh.part];
+            glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.boundsCenter(), 1.0f));
+            meshSpheres.set(m, center, mesh.boundsRadius() * maxAxisScale(transform));
+        }
+        visibility.resize(meshes.size());
+        culler.cull(frustum, meshSpheres, 0, meshes.size(), visibility.data());
+
+        for (size_t m : drawOrder) {
+            const Mesh& mesh = meshes[m];
+            if (!visibility[m] || !frustum.intersectsBox(mesh.boundsMin, mesh.boundsMax, meshTransforms[mesh.part])) {
+                culledDraws++;
+                continue;
+            }
+            unsigned int level = 0;
+            if (lodView.enabled())
+                level = lodView.selectLevel(mesh, lodView.distanceTo(meshSpheres.center(m), meshSpheres.radius[m]));
+            addDraw(mesh, m, level, 1, 0);
+        }
+    }
+
+    // One draw per mesh and used level over the visible robots. With posed bounds from
+    // SetInstanceBounds every mesh of every robot is culled in a single batch and ranked by its
+    // own sphere; without them robots are ranked by the distance to their whole rest-pose
+    // sphere and nothing is culled, since a moving arm may leave it.
+    // instanceList starts with the identity so a level shared by every robot needs no list
+    void buildInstancedDraws(const RobotInstanceBuffer& instances, PersistentRingBuffer* ring) {
+        GLuint count = static_cast<GLuint>(instances.instanceCount);
+        instanceList.resize(count);
+        for (GLuint i = 0; i < count; i++)
+            instanceList[i] = i;
+
+        bool posed = instanceBoundsCount == count && instanceSpheres.size() == meshes.size() * count;
+        bool perInstance = lodView.enabled() && instances.placements.size() == count;
+        if (posed) {
+            visibility.resize(instanceSpheres.size());
+            culler.cull(frustum, instanceSpheres, 0, instanceSpheres.size(), visibility.data());
+        }
+        else if (perInstance) {
+            instanceDistances.resize(count);
+            for (GLuint i = 0; i < count; i++) {
+                glm::vec3 center = sphereCenter + glm::vec3(instances.placements[i].origin);
+                instanceDistances[i] = lodView.distanceTo(center, sphereRadius);
+            }
+        }
+
+        for (size_t m : drawOrder) {
+            const Mesh& mesh = meshes[m];
+            if (!posed && !perInstance) {
+                addDraw(mesh, m, 0, count, 0);
+                continue;
+            }
+            for (std::vector<GLuint>& bucket : lodBuckets)
+                bucket.clear();
+            for (GLuint i = 0; i < count; i++) {
+                unsigned int level = 0;
+                if (posed) {
+                    size_t k = m * count + i;
+                    if (!visibility[k]) {
+                        culledDraws++;
+                        continue;
+                    }
+                    if (lodView.enabled())
+                        level = lodView.selectLevel(mesh, lodView.distanceTo(instanceSpheres.center(k), instanceSpheres.radius[k]));
+                }
+                else {
+                    level = lodView.selectLevel(mesh, instanceDistances[i]);
+                }
+                lodBuckets[level].push_back(i);
+            }
+            for (unsigned int level = 0; level < kMaxMeshLods; level++) {
+                const std::vector<GLuint>& bucket = lodBuckets[level];
+                if (bucket.empty())
+                    continue;
+                GLuint base = 0;
+                if (bucket.size() != count) {
+                    base = static_cast<GLuint>(instanceList.size());
+                    instanceList.insert(instanceList.end(), bucket.begin(), bucket.end());
+                }
+                addDraw(mesh, m, level, static_cast<GLuint>(bucket.size()), base);
+            }
+        }
+        drawCommands.setInstanceList(instanceList, ring);
+    }
+
     void loadModel(std::string const& path) {
+        directory = path.substr(0, path.find_last_of('/'));
+        sourcePath = path;
+        cachePath = path + ".meshcache";
+
+        // Warm start: upload straight from the mapped cache when it matches the source file
+        bool hashed = MeshCache::hashFile(path, sourceHash);
+        if (hashed)
+            MeshCache::hashCompanion(path.substr(0, path.find_last_of('.')) + ".mtl", sourceHash);
+        if (hashed && loadFromCache()) {
+            return;
+        }
+
         Assimp::Importer importer;
+        const aiScene* scene = importScene(importer, path);
+        if (!scene)
+            return;
+
+        meshes.reserve(scene->mNumMeshes);
+        processNode(scene->mRootNode, scene, meshes, importStats);
+        importMaterials(scene);
+
+        allocateGeometry();
+        for (Mesh& mesh : meshes) {
+            geometry.append(mesh, mesh.vertices.data(), mesh.indices.data());
+        }
+        geometry.finish();
+
+        if (hashed) {
+            MeshCache::write(cachePath, sourceHash, meshes, materials);
+        }
+        for (Mesh& mesh : meshes) {
+            mesh.setResidency(residency);
+        }
+    }
+
+    const aiScene* importScene(Assimp::Importer& importer, std::string const& path) {
         const aiScene* scene = importer.ReadFile(path,
             aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
             std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-            return;
+            return nullptr;
         }
+        return scene;
+    }
 
-        directory = path.substr(0, path.find_last_of('/'));
-        processNode(scene->mRootNode, scene);
+    bool loadFromCache() {
+        MeshCache::MappedFile cache;
+        if (!cache.open(cachePath))
+            return false;
+
+        uint32_t meshCount = 0, materialCount = 0;
+        const Material* cachedMaterials = nullptr;
+        const MeshCache::MeshRecord* records = MeshCache::validate(cache, sourceHash, meshCount,
+            cachedMaterials, materialCount);
+        if (!records)
+            return false;
+
+        materials.assign(cachedMaterials, cachedMaterials + materialCount);
+        meshes.reserve(meshCount);
+        for (uint32_t i = 0; i < meshCount; i++) {
+            const MeshCache::MeshRecord& r = records[i];
+            meshes.emplace_back(r.vertexCount, r.indexCount,
+                glm::vec3(r.boundsMin[0], r.boundsMin[1], r.boundsMin[2]),
+                glm::vec3(r.boundsMax[0], r.boundsMax[1], r.boundsMax[2]),
+                r.materialIndex);
+            meshes.back().part = r.part;
+            meshes.back().lods.clear();
+            for (uint32_t l = 0; l < r.lodCount; l++)
+                meshes.back().lods.push_back({ r.lods[l].firstIndex, r.lods[l].indexCount, r.lods[l].error });
+        }
+
+        allocateGeometry();
+        for (uint32_t i = 0; i < meshCount; i++) {
+            geometry.append(meshes[i],
+                reinterpret_cast<const Vertex*>(cache.data() + records[i].vertexOffset),
+                reinterpret_cast<const unsigned int*>(cache.data() + records[i].indexOffset));
+        }
+        geometry.finish();
+
+        // Only policies that keep a CPU copy pay for reading it out of the mapping
+        if (residency != RESIDENCY_RELEASE) {
+            for (uint32_t i = 0; i < meshCount; i++) {
+                restoreFromRecord(meshes[i], cache, records[i]);
+                meshes[i].setResidency(residency);
+            }
+        }
+        return true;
+    }
+
+    bool rehydrateFromCache() {
+        MeshCache::MappedFile cache;
+        if (!cache.open(cachePath))
+            return false;
+
+        uint32_t meshCount = 0, materialCount = 0;
+        const Material* cachedMaterials = nullptr;
+        const MeshCache::MeshRecord* records = MeshCache::validate(cache, sourceHash, meshCount,
+            cachedMaterials, materialCount);
+        if (!records || meshCount != meshes.size())
+            return false;
+
+        for (uint32_t i = 0; i < meshCount; i++) {
+            if (meshes[i].residency != RESIDENCY_KEEP)
+                restoreFromRecord(meshes[i], cache, records[i]);
+        }
+        return true;
     }
 
-    void processNode(aiNode* node, const aiScene* scene) {
+    static void restoreFromRecord(Mesh& mesh, const MeshCache::MappedFile& cache, const MeshCache::MeshRecord& record) {
+        const Vertex* vertices = reinterpret_cast<const Vertex*>(cache.data() + record.vertexOffset);
+        const unsigned int* indices = reinterpret_cast<const unsigned int*>(cache.data() + record.indexOffset);
+        mesh.restore(std::vector<Vertex>(vertices, vertices + record.vertexCount),
+            std::vector<unsigned int>(indices, indices + record.indexCount));
+    }
+
+    // Picks 16-bit indices whenever every mesh fits, which the import-time split guarantees
+    void allocateGeometry() {
+        size_t vertexTotal = 0, indexTotal = 0;
+        bool shortIndices = true;
+        for (const Mesh& mesh : meshes) {
+            vertexTotal += mesh.vertexCount;
+            indexTotal += mesh.indexCount;
+            shortIndices = shortIndices && mesh.vertexCount <= MeshOptimizer::kMaxShortIndexVertices;
+        }
+        geometry.allocate(vertexTotal, indexTotal, vertexFormat,
+            shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT);
+    }
+
+    // Phong parameters of every Assimp material. Blender writes Ka 1 for every material, so the
+    // ambient reflectance is taken as Ka * Kd to keep the part colour in the shadows
+    void importMaterials(const aiScene* scene) {
+        materials.clear();
+        materials.reserve(scene->mNumMaterials);
+        for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+            const aiMaterial* source = scene->mMaterials[i];
+            aiColor3D ambient(1.0f, 1.0f, 1.0f), diffuse(0.8f, 0.8f, 0.8f), specular(0.0f, 0.0f, 0.0f);
+            float shininess = 32.0f;
+            source->Get(AI_MATKEY_COLOR_AMBIENT, ambient);
+            source->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+            source->Get(AI_MATKEY_COLOR_SPECULAR, specular);
+            source->Get(AI_MATKEY_SHININESS, shininess);
+            glm::vec3 kd(diffuse.r, diffuse.g, diffuse.b);
+            materials.push_back(Material::make(glm::vec3(ambient.r, ambient.g, ambient.b) * kd, kd,
+                glm::vec3(specular.r, specular.g, specular.b), std::max(shininess, 1.0f)));
+        }
+    }
+
+    // Points meshes without a valid material at entry 0, uploads the table and orders the
+    // draws by material so equal materials end up next to each other in every draw list
+    void resolveMaterials() {
+        if (materials.empty())
+            materials.push_back(Material::fallback());
+        for (Mesh& mesh : meshes) {
+            if (mesh.materialIndex >= materials.size())
+                mesh.materialIndex = 0;
+        }
+        materialTable.upload(materials);
+
+        drawOrder.resize(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++)
+            drawOrder[m] = m;
+        std::stable_sort(drawOrder.begin(), drawOrder.end(), [this](size_t a, size_t b) {
+            if (meshes[a].materialIndex != meshes[b].materialIndex)
+                return meshes[a].materialIndex < meshes[b].materialIndex;
+            return meshes[a].part < meshes[b].part;
+        });
+    }
+
+    void processNode(aiNode* node, const aiScene* scene, std::vector<Mesh>& out, MeshOptimizer::Stats& stats) {
         for (unsigned int i = 0; i < node->mNumMeshes; i++) {
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            processMesh(mesh, out, stats);
         }
 
         for (unsigned int i = 0; i < node->mNumChildren; i++) {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, out, stats);
         }
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene) {
-        std::vector<Vertex> vertices;
+    // Appends the meshes of one part: a single one, or several if it needs splitting for 16-bit indices
+    void processMesh(aiMesh* mesh, std::vector<Mesh>& out, MeshOptimizer::Stats& stats) {
+        // Sized once up front and filled in a single pass, then moved into the Mesh
+        std::vector<Vertex> vertices(mesh->mNumVertices);
         std::vector<unsigned int> indices;
+        indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 
+        const bool hasNormals = mesh->HasNormals();
         for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-            Vertex vertex;
+            Vertex& vertex = vertices[i];
             vertex.Position = glm::vec3(
                 mesh->mVertices[i].x,
                 mesh->mVertices[i].y,
                 mesh->mVertices[i].z
             );
 
-            if (mesh->HasNormals()) {
+            if (hasNormals) {
                 vertex.Normal = glm::vec3(
                     mesh->mNormals[i].x,
                     mesh->mNormals[i].y,
                     mesh->mNormals[i].z
                 );
             }
-            vertices.push_back(vertex);
+            else {
+                vertex.Normal = glm::vec3(0.0f);
+            }
         }
 
         for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-            aiFace face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            const aiFace& face = mesh->mFaces[i];
+            indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
         }
 
-        return Mesh(vertices, indices);
+        // Reorder for the post-transform cache, overdraw and vertex fetch before anything is uploaded
+        stats.accumulate(MeshOptimizer::optimize(vertices, indices));
+
+        unsigned int part = out.empty() ? 0 : out.back().part + 1;
+        std::vector<MeshOptimizer::MeshPiece> pieces =
+            MeshOptimizer::splitForIndexRange(std::move(vertices), std::move(indices));
+        for (MeshOptimizer::MeshPiece& piece : pieces) {
+            std::vector<MeshSimplifier::Level> levels =
+                MeshSimplifier::generateLods(piece.vertices, piece.indices, kMaxMeshLods);
+            out.emplace_back(std::move(piece.vertices), std::move(piece.indices), mesh->mMaterialIndex);
+            out.back().part = part;
+            for (const MeshSimplifier::Level& level : levels)
+                out.back().addLod(level.indices, level.error);
+        }
     }
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+
+// Framebuffer with colour and depth renderbuffers for rendering without a visible window
+class OffscreenTarget {
+public:
+    unsigned int FBO = 0;
+    int width = 0, height = 0;
+
+    OffscreenTarget() = default;
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    ~OffscreenTarget() {
+        release();
+    }
+
+    bool create(int width, int height) {
+        release();
+        this->width = width;
+        this->height = height;
+
+        glGenFramebuffers(1, &FBO);
+        glGenRenderbuffers(1, &colorRBO);
+        glGenRenderbuffers(1, &depthRBO);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (!complete)
+            std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE" << std::endl;
+        return complete;
+    }
+
+    void bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, width, height);
+    }
+
+private:
+    unsigned int colorRBO = 0, depthRBO = 0;
+
+    void release() {
+        if (FBO) glDeleteFramebuffers(1, &FBO);
+        if (colorRBO) glDeleteRenderbuffers(1, &colorRBO);
+        if (depthRBO) glDeleteRenderbuffers(1, &depthRBO);
+        FBO = colorRBO = depthRBO = 0;
+    }
+};
+
+// Ring of pixel pack buffers: glReadPixels only queues a GPU copy and the pixels are mapped
+// a few frames later, once the fence says the copy is done, so capture never stalls the pipeline
+class AsyncReadback {
+public:
+    // Called with the tag passed to request() and bottom-up RGB8 rows
+    using Callback = std::function<void(size_t tag, const unsigned char* rgb, int width, int height)>;
+
+    AsyncReadback() = default;
+    AsyncReadback(const AsyncReadback&) = delete;
+    AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+    // Images still in flight are dropped; call finish() first to receive them
+    ~AsyncReadback() {
+        release();
+    }
+
+    void create(int width, int height, size_t depth, Callback onImage) {
+        release();
+        this->width = width;
+        this->height = height;
+        this->onImage = onImage;
+        slots.resize(depth);
+        for (Slot& slot : slots) {
+            glGenBuffers(1, &slot.PBO);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 3, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        next = 0;
+    }
+
+    // Queues a copy of the currently bound read framebuffer
+    void request(size_t tag) {
+        Slot& slot = slots[next];
+        if (slot.fence)
+            complete(slot, GL_TIMEOUT_IGNORED);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, (void*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.tag = tag;
+
+        next = (next + 1) % slots.size();
+    }
+
+    // Delivers every image whose copy has already finished, without waiting
+    void poll() {
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot& slot = slots[(next + i) % slots.size()];
+            if (slot.fence && !complete(slot, 0))
+                break;
+        }
+    }
+
+    // Waits for and delivers all outstanding images in request order
+    void finish() {
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot& slot = slots[(next + i) % slots.size()];
+            if (slot.fence)
+                complete(slot, GL_TIMEOUT_IGNORED);
+        }
+    }
+
+private:
+    struct Slot {
+        unsigned int PBO = 0;
+        GLsync fence = 0;
+        size_t tag = 0;
+    };
+
+    std::vector<Slot> slots;
+    size_t next = 0;
+    int width = 0, height = 0;
+    Callback onImage;
+
+    void release() {
+        GLStateCache& state = GLStateCache::current();
+        for (Slot& slot : slots) {
+            if (slot.fence) glDeleteSync(slot.fence);
+            if (slot.PBO) {
+                state.forgetBuffer(slot.PBO);
+                glDeleteBuffers(1, &slot.PBO);
+            }
+        }
+        slots.clear();
+        next = 0;
+    }
+
+    bool complete(Slot& slot, GLuint64 timeout) {
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+        const unsigned char* pixels = static_cast<const unsigned char*>(
+            glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(width) * height * 3, GL_MAP_READ_BIT));
+        if (pixels) {
+            onImage(slot.tag, pixels, width, height);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return true;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// Per-frame CPU stage timings plus whole-frame GPU time from GL_TIME_ELAPSED queries.
+// Queries are read back only once available, so profiling never stalls; a frame that finds
+// every query still in flight gets a new one, up to kMaxQueries, and is left untimed beyond that.
+class FrameProfiler {
+public:
+    enum Stage {
+        STAGE_INPUT,
+        STAGE_TRANSFORMS,
+        STAGE_UPLOAD,
+        STAGE_DRAW,
+        STAGE_SWAP,
+        STAGE_COUNT
+    };
+
+    // Rolling window used for percentiles
+    static const size_t kWindow = 1024;
+    // Frames kept for the dump; older ones are dropped
+    static const size_t kHistory = 65536;
+    static const size_t kInitialQueries = 4;
+    static const size_t kMaxQueries = 16;
+
+    FrameProfiler() {
+        for (size_t i = 0; i < kInitialQueries; i++)
+            addQuery();
+    }
+
+    ~FrameProfiler() {
+        for (const QuerySlot& slot : querySlots)
+            glDeleteQueries(1, &slot.query);
+    }
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    void beginFrame() {
+        collectGpuResults();
+        current = Record();
+        frameStart = Clock::now();
+
+        activeQuery = freeQuery();
+        if (activeQuery) {
+            glBeginQuery(GL_TIME_ELAPSED, activeQuery->query);
+            activeQuery->frame = frameIndex;
+            activeQuery->pending = true;
+        }
+    }
+
+    void beginStage(Stage stage) {
+        stageStart[stage] = Clock::now();
+    }
+
+    void endStage(Stage stage) {
+        current.cpu[stage] += seconds(stageStart[stage], Clock::now());
+    }
+
+    void endFrame() {
+        if (activeQuery)
+            glEndQuery(GL_TIME_ELAPSED);
+        activeQuery = nullptr;
+        current.cpuFrame = seconds(frameStart, Clock::now());
+        records.push_back(current);
+        if (records.size() > kHistory) {
+            records.pop_front();
+            firstFrame++;
+        }
+        frameIndex++;
+    }
+
+    // Frames profiled so far, including those no longer kept
+    size_t frameCount() const { return frameIndex; }
+
+    // q in [0, 1] over the last kWindow frames; stage == STAGE_COUNT gives the whole CPU frame
+    double cpuPercentile(Stage stage, double q) const {
+        std::vector<double> values;
+        size_t first = records.size() > kWindow ? records.size() - kWindow : 0;
+        for (size_t i = first; i < records.size(); i++)
+            values.push_back(stage == STAGE_COUNT ? records[i].cpuFrame : records[i].cpu[stage]);
+        return percentile(values, q);
+    }
+
+    double gpuPercentile(double q) const {
+        std::vector<double> values;
+        size_t first = records.size() > kWindow ? records.size() - kWindow : 0;
+        for (size_t i = first; i < records.size(); i++)
+            if (records[i].gpuFrame >= 0.0)
+                values.push_back(records[i].gpuFrame);
+        return percentile(values, q);
+    }
+
+    // Short text for the window title
+    std::string overlay() const {
+        char text[160];
+        std::snprintf(text, sizeof(text), "CPU p50 %.2f / p99 %.2f ms | GPU p50 %.2f / p99 %.2f ms",
+            cpuPercentile(STAGE_COUNT, 0.5) * 1e3, cpuPercentile(STAGE_COUNT, 0.99) * 1e3,
+            gpuPercentile(0.5) * 1e3, gpuPercentile(0.99) * 1e3);
+        return text;
+    }
+
+    // Writes every recorded frame; the format follows the extension (.json, otherwise CSV)
+    bool dump(const std::string& path) {
+        collectGpuResults();
+        FILE* out = std::fopen(path.c_str(), "w");
+        if (!out) {
+            std::cerr << "ERROR::PROFILER::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        if (json) {
+            std::fprintf(out, "{\n  \"summary\": {");
+            for (int s = 0; s <= STAGE_COUNT; s++) {
+                Stage stage = static_cast<Stage>(s);
+                std::fprintf(out, "%s\n    \"%s\": { \"p50_ms\": %.4f, \"p99_ms\": %.4f }", s ? "," : "",
+                    stageName(stage), cpuPercentile(stage, 0.5) * 1e3, cpuPercentile(stage, 0.99) * 1e3);
+            }
+            std::fprintf(out, ",\n    \"gpu\": { \"p50_ms\": %.4f, \"p99_ms\": %.4f }\n  },\n  \"frames\": [",
+                gpuPercentile(0.5) * 1e3, gpuPercentile(0.99) * 1e3);
+            for (size_t i = 0; i < records.size(); i++) {
+                const Record& r = records[i];
+                std::fprintf(out, "%s\n    [", i ? "," : "");
+                for (int s = 0; s < STAGE_COUNT; s++)
+                    std::fprintf(out, "%.4f, ", r.cpu[s] * 1e3);
+                std::fprintf(out, "%.4f, %.4f]", r.cpuFrame * 1e3, r.gpuFrame * 1e3);
+            }
+            std::fprintf(out, "\n  ],\n  \"columns\": [");
+            for (int s = 0; s <= STAGE_COUNT; s++)
+                std::fprintf(out, "\"%s_ms\", ", stageName(static_cast<Stage>(s)));
+            std::fprintf(out, "\"gpu_ms\"]\n}\n");
+        }
+        else {
+            std::fprintf(out, "frame");
+            for (int s = 0; s <= STAGE_COUNT; s++)
+                std::fprintf(out, ",%s_ms", stageName(static_cast<Stage>(s)));
+            std::fprintf(out, ",gpu_ms\n");
+            for (size_t i = 0; i < records.size(); i++) {
+                const Record& r = records[i];
+                std::fprintf(out, "%zu", firstFrame + i);
+                for (int s = 0; s < STAGE_COUNT; s++)
+                    std::fprintf(out, ",%.4f", r.cpu[s] * 1e3);
+                std::fprintf(out, ",%.4f,%.4f\n", r.cpuFrame * 1e3, r.gpuFrame * 1e3);
+            }
+        }
+        return std::fclose(out) == 0;
+    }
+
+    static const char* stageName(Stage stage) {
+        switch (stage) {
+        case STAGE_INPUT: return "input";
+        case STAGE_TRANSFORMS: return "transforms";
+        case STAGE_UPLOAD: return "upload";
+        case STAGE_DRAW: return "draw";
+        case STAGE_SWAP: return "swap";
+        default: return "frame";
+        }
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Record {
+        double cpu[STAGE_COUNT] = {};
+        double cpuFrame = 0.0;
+        double gpuFrame = -1.0;     // -1 until the query result arrives
+    };
+
+    struct QuerySlot {
+        GLuint query = 0;
+        size_t frame = 0;
+        bool pending = false;
+    };
+
+    // records[i] is frame firstFrame + i
+    std::deque<Record> records;
+    size_t firstFrame = 0;
+    Record current;
+    Clock::time_point frameStart;
+    Clock::time_point stageStart[STAGE_COUNT];
+
+    std::deque<QuerySlot> querySlots;
+    QuerySlot* activeQuery = nullptr;
+    size_t frameIndex = 0;
+
+    static double seconds(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+    static double percentile(std::vector<double>& values, double q) {
+        if (values.empty())
+            return 0.0;
+        size_t index = static_cast<size_t>(q * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    void addQuery() {
+        querySlots.emplace_back();
+        glGenQueries(1, &querySlots.back().query);
+    }
+
+    // A query whose result has been collected, or nullptr when all are in flight and the
+    // pool is at kMaxQueries
+    QuerySlot* freeQuery() {
+        for (QuerySlot& slot : querySlots) {
+            if (!slot.pending)
+                return &slot;
+        }
+        if (querySlots.size() >= kMaxQueries)
+            return nullptr;
+        addQuery();
+        return &querySlots.back();
+    }
+
+    // Reads finished queries; a query still in flight is left for a later frame
+    void collectGpuResults() {
+        for (QuerySlot& slot : querySlots) {
+            if (!slot.pending || slot.frame >= frameIndex)
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+            if (slot.frame >= firstFrame)
+                records[slot.frame - firstFrame].gpuFrame = elapsed * 1e-9;
+            slot.pending = false;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "model.h"
+#include "robot_instances.h"
+#include "gpu_culling.h"
+#include "shader.h"
+
+// Model submissions of one frame, executed in the order of a 64-bit sort key so submissions
+// sharing a program, vertex array and material table run back to back and GLStateCache drops
+// the binds they have in common. Key bits, most significant first:
+//   program (16) | vertex array (16) | material table (12) | depth (20)
+// GL names wider than their field only weaken the grouping, never the result. Within one state
+// group items go front to back for early depth rejection
+class RenderQueue {
+public:
+    enum ItemType {
+        ITEM_SINGLE,
+        ITEM_INSTANCED,
+        ITEM_CULLED
+    };
+
+    struct Item {
+        uint64_t key;
+        ItemType type;
+        Model* model;
+        Shader* shader;
+        const RobotInstanceBuffer* instances;
+        GpuCuller* culler;
+    };
+
+    static const uint32_t kDepthBits = 20;
+
+    // depth is the view distance normalized to [0, 1]; values outside are clamped
+    static uint64_t makeKey(GLuint program, GLuint vertexArray, GLuint material, float depth) {
+        const float depthMax = float((1u << kDepthBits) - 1);
+        uint64_t quantized = static_cast<uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * depthMax);
+        return (uint64_t(program & 0xFFFF) << 48) | (uint64_t(vertexArray & 0xFFFF) << 32) |
+            (uint64_t(material & 0xFFF) << kDepthBits) | quantized;
+    }
+
+    // Camera the depth field is measured from; farPlane maps to the largest depth
+    void setView(const glm::vec3& eye, float farPlane) {
+        this->eye = eye;
+        this->farPlane = farPlane;
+    }
+
+    // The single posed robot of model, see Model::Draw
+    void submit(Model& model, Shader& shader) {
+        float depth = farPlane > 0.0f ? glm::length(model.BoundingCenter() - eye) / farPlane : 0.0f;
+        push(ITEM_SINGLE, model, shader, nullptr, nullptr, depth);
+    }
+
+    // Every robot of instances, see Model::DrawInstanced. The fleet spans the scene, so it
+    // sorts as nearest
+    void submitInstanced(Model& model, Shader& shader, const RobotInstanceBuffer& instances) {
+        push(ITEM_INSTANCED, model, shader, &instances, nullptr, 0.0f);
+    }
+
+    // Every robot of instances culled on the GPU, see Model::DrawCulled
+    void submitCulled(Model& model, Shader& shader, const RobotInstanceBuffer& instances, GpuCuller& culler) {
+        push(ITEM_CULLED, model, shader, &instances, &culler, 0.0f);
+    }
+
+    // Sorts and executes everything submitted since the last flush. Equal keys keep their
+    // submission order
+    void flush() {
+        std::stable_sort(items.begin(), items.end(),
+            [](const Item& a, const Item& b) { return a.key < b.key; });
+        for (const Item& item : items) {
+            switch (item.type) {
+            case ITEM_SINGLE:
+                item.model->Draw(*item.shader);
+                break;
+            case ITEM_INSTANCED:
+                item.model->DrawInstanced(*item.shader, *item.instances);
+                break;
+            case ITEM_CULLED:
+                item.model->DrawCulled(*item.shader, *item.instances, *item.culler);
+                break;
+            }
+        }
+        items.clear();
+    }
+
+    size_t size() const {
+        return items.size();
+    }
+
+private:
+    std::vector<Item> items;
+    glm::vec3 eye = glm::vec3(0.0f);
+    float farPlane = 0.0f;
+
+    void push(ItemType type, Model& model, Shader& shader, const RobotInstanceBuffer* instances,
+        GpuCuller* culler, float depth) {
+        uint64_t key = makeKey(shader.ID, model.geometry.VAO, model.MaterialBuffer(), depth);
+        items.push_back({ key, type, &model, &shader, instances, culler });
+    }
+};
\ No newline at end of file
@@ -0,0 +1,258 @@
+#pragma once
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "gl_state.h"
+
+// Triple-buffered, persistently mapped buffer for per-frame dynamic data.
+// The CPU writes straight into the mapping and the GPU reads the data in place, through ranges
+// bound to uniform/storage binding points or as the indirect draw buffer. Each frame's region
+// is guarded by a fence so it is only rewritten after the GPU has finished the frame that read it.
+class PersistentRingBuffer {
+public:
+    static const unsigned int kFrames = 3;
+
+    struct Allocation {
+        unsigned char* ptr = nullptr;
+        GLintptr offset = 0;        // offset into buffer, usable with glBindBufferRange
+    };
+
+    unsigned int buffer = 0;
+
+    PersistentRingBuffer() = default;
+    PersistentRingBuffer(const PersistentRingBuffer&) = delete;
+    PersistentRingBuffer& operator=(const PersistentRingBuffer&) = delete;
+
+    ~PersistentRingBuffer() {
+        for (GLsync& fence : fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        if (buffer) {
+            GLStateCache::current().forgetBuffer(buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+
+    bool create(GLsizeiptr frameCapacity) {
+        this->frameCapacity = frameCapacity;
+        // Every allocation may be bound as a uniform or storage range
+        GLint uniformAlignment = 0, storageAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+        alignment = std::max<GLsizeiptr>({ 16, uniformAlignment, storageAlignment });
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, frameCapacity * kFrames, NULL, flags);
+        mapping = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frameCapacity * kFrames, flags));
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        if (!mapping)
+            std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl;
+        return mapping != nullptr;
+    }
+
+    // Waits (normally not at all) until the GPU is done with the region this frame will reuse
+    void beginFrame() {
+        GLsync& fence = fences[region];
+        if (fence) {
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            while (status == GL_TIMEOUT_EXPIRED) {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            }
+            glDeleteSync(fence);
+            fence = 0;
+        }
+        cursor = 0;
+        frame++;
+    }
+
+    // Counts beginFrame() calls; an allocation is only valid during the frame it was made in
+    uint64_t frameSerial() const {
+        return frame;
+    }
+
+    // Marks the region as in use by the commands submitted this frame and moves to the next one
+    void endFrame() {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % kFrames;
+    }
+
+    // Sub-allocates from the current frame's region, aligned for glBindBufferRange; returns a
+    // null ptr when the region is full
+    Allocation allocate(GLsizeiptr size) {
+        Allocation result;
+        GLsizeiptr start = (cursor + alignment - 1) / alignment * alignment;
+        if (!mapping || start + size > frameCapacity)
+            return result;
+        cursor = start + size;
+        result.offset = region * frameCapacity + start;
+        result.ptr = mapping + result.offset;
+        return result;
+    }
+
+private:
+    unsigned char* mapping = nullptr;
+    GLsizeiptr frameCapacity = 0;
+    GLsizeiptr cursor = 0;
+    GLsizeiptr alignment = 256;
+    unsigned int region = 0;
+    uint64_t frame = 0;
+    GLsync fences[kFrames] = {};
+};
+
+// Contents of one buffer binding the CPU rewrites between frames: uniform blocks, draw commands
+// and records, instance lists, joint angles. A write with a ring lands in the current frame's
+// region and range() points there, so the GPU reads the data where the CPU put it. A ring range
+// only lives for its frame; contents still unchanged in a later frame move once into an owned
+// buffer, which also takes every write made without a ring or with the region full
+class StreamBuffer {
+public:
+    // Where the contents are for the current frame; size 0 when there are none
+    struct Range {
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    StreamBuffer() = default;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    StreamBuffer(StreamBuffer&& other) noexcept {
+        swap(other);
+    }
+
+    StreamBuffer& operator=(StreamBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~StreamBuffer() {
+        release();
+    }
+
+    // Replaces the contents; writing what is already there costs nothing
+    void assign(const void* data, size_t size, PersistentRingBuffer* ring) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        if (size == contents.size() && (size == 0 || std::memcmp(contents.data(), bytes, size) == 0))
+            return;
+        contents.assign(bytes, bytes + size);
+        publish(0, size, ring);
+    }
+
+    // Replaces contents[offset, offset + size), growing the contents to fit. Without a ring only
+    // that range is uploaded; the ring always receives the whole contents
+    void write(size_t offset, const void* data, size_t size, PersistentRingBuffer* ring) {
+        if (offset + size > contents.size())
+            contents.resize(offset + size);
+        if (size > 0)
+            std::memcpy(contents.data() + offset, data, size);
+        publish(offset, size, ring);
+    }
+
+    size_t size() const {
+        return contents.size();
+    }
+
+    Range range() const {
+        bool current = inRing ? ring->frameSerial() == ringFrame : ownedValid;
+        if (!current)
+            uploadOwned(0, contents.size());
+        return location;
+    }
+
+    void bind(GLenum target, GLuint index) const {
+        Range current = range();
+        if (current.size > 0)
+            GLStateCache::current().bindBufferRange(target, index, current.buffer, current.offset, current.size);
+        else
+            GLStateCache::current().bindBufferBase(target, index, current.buffer);
+    }
+
+private:
+    std::vector<unsigned char> contents;
+    PersistentRingBuffer* ring = nullptr;
+    uint64_t ringFrame = 0;
+    // range() settles stale ring contents into the owned buffer
+    mutable bool inRing = false;
+    mutable unsigned int owned = 0;
+    mutable size_t ownedCapacity = 0;
+    mutable bool ownedValid = false;
+    mutable Range location;
+
+    void publish(size_t offset, size_t size, PersistentRingBuffer* ring) {
+        this->ring = ring;
+        inRing = false;
+        if (ring && !contents.empty()) {
+            PersistentRingBuffer::Allocation allocation = ring->allocate(static_cast<GLsizeiptr>(contents.size()));
+            if (allocation.ptr) {
+                std::memcpy(allocation.ptr, contents.data(), contents.size());
+                location = { ring->buffer, allocation.offset, static_cast<GLsizeiptr>(contents.size()) };
+                ringFrame = ring->frameSerial();
+                inRing = true;
+                ownedValid = false;
+                return;
+            }
+        }
+        if (ownedValid)
+            uploadOwned(offset, size);
+        else
+            uploadOwned(0, contents.size());
+    }
+
+    void uploadOwned(size_t offset, size_t size) const {
+        if (!owned)
+            glGenBuffers(1, &owned);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, owned);
+        if (contents.size() > ownedCapacity) {
+            glBufferData(GL_COPY_WRITE_BUFFER, contents.size(), contents.data(), GL_DYNAMIC_DRAW);
+            ownedCapacity = contents.size();
+        }
+        else if (size > 0) {
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, contents.data() + offset);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        inRing = false;
+        ownedValid = true;
+        location = { owned, 0, static_cast<GLsizeiptr>(contents.size()) };
+    }
+
+    void release() {
+        if (owned) {
+            GLStateCache::current().forgetBuffer(owned);
+            glDeleteBuffers(1, &owned);
+        }
+        contents.clear();
+        ring = nullptr;
+        inRing = false;
+        owned = 0;
+        ownedCapacity = 0;
+        ownedValid = false;
+        location = Range();
+    }
+
+    void swap(StreamBuffer& other) {
+        contents.swap(other.contents);
+        std::swap(ring, other.ring);
+        std::swap(ringFrame, other.ringFrame);
+        std::swap(inRing, other.inRing);
+        std::swap(owned, other.owned);
+        std::swap(ownedCapacity, other.ownedCapacity);
+        std::swap(ownedValid, other.ownedValid);
+        std::swap(location, other.location);
+    }
+};
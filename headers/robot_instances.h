@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "indirect_draw.h"
+#include "kinematic_chain.h"
+
+// std430 mirrors of the buffers read by shaders/instanced.vert
+struct JointGpu {
+    glm::vec4 pivot;    // xyz = pivot point in model space
+    glm::vec3 axis;     // unit rotation axis
+    int32_t parent;     // -1 for a root joint
+};
+
+struct RobotInstance {
+    glm::vec4 origin;   // xyz = placement of the robot base
+};
+
+// Shared joint hierarchy plus per-instance joint states for instanced rendering.
+// Angles are stored flat, jointCount radians per instance.
+class RobotInstanceBuffer {
+public:
+    unsigned int jointBuffer = 0;
+    unsigned int instanceBuffer = 0;
+    GLsizei instanceCount = 0;
+    // CPU copy of the placements, used for per-instance LOD selection
+    std::vector<RobotInstance> placements;
+
+    RobotInstanceBuffer() = default;
+    RobotInstanceBuffer(const RobotInstanceBuffer&) = delete;
+    RobotInstanceBuffer& operator=(const RobotInstanceBuffer&) = delete;
+
+    ~RobotInstanceBuffer() {
+        GLStateCache& state = GLStateCache::current();
+        for (GLuint buffer : { jointBuffer, instanceBuffer }) {
+            if (buffer) {
+                state.forgetBuffer(buffer);
+                glDeleteBuffers(1, &buffer);
+            }
+        }
+    }
+
+    void setJoints(const KinematicChain& chain) {
+        std::vector<JointGpu> joints(chain.size());
+        for (size_t i = 0; i < chain.size(); ++i) {
+            joints[i].pivot = glm::vec4(chain.joints[i].pivot, 0.0f);
+            joints[i].axis = chain.joints[i].axis;
+            joints[i].parent = chain.joints[i].parent;
+        }
+
+        if (!jointBuffer) glGenBuffers(1, &jointBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, jointBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, joints.size() * sizeof(JointGpu), joints.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    void setInstances(const std::vector<RobotInstance>& instances) {
+        if (!instanceBuffer) glGenBuffers(1, &instanceBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(RobotInstance), instances.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        instanceCount = static_cast<GLsizei>(instances.size());
+        placements = instances;
+    }
+
+    // Angles that change every frame are read straight from the ring; a still pose settles in
+    // an owned buffer after one upload
+    void setAngles(const std::vector<float>& angles, PersistentRingBuffer* ring = nullptr) {
+        angleStream.assign(angles.data(), angles.size() * sizeof(float), ring);
+    }
+
+    void bind() const {
+        GLStateCache& state = GLStateCache::current();
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, JOINTS_BINDING, jointBuffer);
+        state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, ROBOT_INSTANCES_BINDING, instanceBuffer);
+        angleStream.bind(GL_SHADER_STORAGE_BUFFER, INSTANCE_ANGLES_BINDING);
+    }
+
+private:
+    StreamBuffer angleStream;
+};
\ No newline at end of file
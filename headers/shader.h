@@ -3,118 +3,237 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "gl_state.h"
 
-class Shader
-{
-public:
-    unsigned int ID;
+// Source loading and compile checks shared by Shader and ComputeShader
+namespace ShaderSource {
 
-    Shader(const char* vertexPath, const char* fragmentPath) {
-        // 1. Retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
+    // Utility function for checking shader compilation/linking errors
+    inline void checkCompileErrors(unsigned int shader, const std::string& type) {
+        int success;
+        char infoLog[1024];
+        if (type != "PROGRAM") {
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+        else {
+            glGetProgramiv(shader, GL_LINK_STATUS, &success);
+            if (!success) {
+                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+            }
+        }
+    }
 
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    // One level deep: included files are not scanned again
+    inline void resolveIncludes(std::string& code, const std::string& path) {
+        const std::string directive = "#include \"";
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        size_t pos = 0;
+        while ((pos = code.find(directive, pos)) != std::string::npos) {
+            size_t nameBegin = pos + directive.size();
+            size_t nameEnd = code.find('"', nameBegin);
+            size_t lineEnd = std::min(code.find('\n', pos), code.size());
+            if ((pos > 0 && code[pos - 1] != '\n') || nameEnd == std::string::npos || nameEnd > lineEnd) {
+                pos = nameBegin;
+                continue;
+            }
+            std::string name = code.substr(nameBegin, nameEnd - nameBegin);
+            std::ifstream file(directory + name);
+            if (!file) {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << directory + name << std::endl;
+                pos = lineEnd;
+                continue;
+            }
+            std::stringstream stream;
+            stream << file.rdbuf();
+            std::string included = stream.str();
+            code.replace(pos, lineEnd - pos, included);
+            pos += included.size();
+        }
+    }
+
+    inline void injectDefines(std::string& code, const std::string& defines) {
+        size_t version = code.find("#version");
+        size_t lineEnd = version == std::string::npos ? std::string::npos : code.find('\n', version);
+        if (lineEnd == std::string::npos)
+            code.insert(0, defines);
+        else
+            code.insert(lineEnd + 1, defines);
+    }
+
+    // File contents with #include lines resolved and defines inserted right after #version
+    inline std::string load(const char* path, const std::string& defines) {
+        std::string code;
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
         try {
-            // Open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-
-            // Read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-
-            // Close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-
-            // Convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            code = stream.str();
         }
         catch (std::ifstream::failure& e) {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
+        resolveIncludes(code, path);
+        if (!defines.empty())
+            injectDefines(code, defines);
+        return code;
+    }
 
-        // 2. Compile shaders
-        unsigned int vertex, fragment;
+    // Compiles one stage and reports errors under type; the caller deletes it after linking
+    inline unsigned int compile(GLenum stage, const std::string& code, const std::string& type) {
+        const char* source = code.c_str();
+        unsigned int shader = glCreateShader(stage);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        checkCompileErrors(shader, type);
+        return shader;
+    }
+}
 
-        // Vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
+class Shader
+{
+public:
+    unsigned int ID;
 
-        // Fragment shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+    // Pre-resolved uniform location; T only selects the matching set() overload
+    template<typename T>
+    struct Uniform {
+        GLint location = -1;
+        bool valid() const { return location >= 0; }
+    };
+
+    // defines (e.g. "#define PACKED_VERTICES\n") are inserted right after the #version line of both stages.
+    // Lines of the form #include "file" are replaced by that file from the stage's directory
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines = "") {
+        // 1. Retrieve the vertex/fragment source code from filePath
+        std::string vertexCode = ShaderSource::load(vertexPath, defines);
+        std::string fragmentCode = ShaderSource::load(fragmentPath, defines);
+
+        // 2. Compile shaders
+        unsigned int vertex = ShaderSource::compile(GL_VERTEX_SHADER, vertexCode, "VERTEX");
+        unsigned int fragment = ShaderSource::compile(GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT");
 
         // Shader program
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        ShaderSource::checkCompileErrors(ID, "PROGRAM");
+        introspectUniforms();
 
         // Delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
     }
 
+    // Skipped when the program is already current
     void use() {
-        glUseProgram(ID);
+        GLStateCache::current().useProgram(ID);
+    }
+
+    // Resolve a handle once from the table built after link; unknown names give an invalid handle
+    template<typename T>
+    Uniform<T> uniform(const std::string& name) const {
+        Uniform<T> handle;
+        handle.location = location(name);
+        return handle;
+    }
+
+    // Handle-based setters for hot paths
+    void set(Uniform<bool> u, bool value) const {
+        glUniform1i(u.location, (int)value);
+    }
+    void set(Uniform<int> u, int value) const {
+        glUniform1i(u.location, value);
+    }
+    void set(Uniform<float> u, float value) const {
+        glUniform1f(u.location, value);
+    }
+    void set(Uniform<glm::vec3> u, const glm::vec3& value) const {
+        glUniform3fv(u.location, 1, &value[0]);
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4& mat) const {
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, &mat[0][0]);
     }
 
     // Utility uniform functions
     void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
     void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(name), value);
     }
     void setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(name), value);
     }
     void setVec3(const std::string& name, const glm::vec3& value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(location(name), 1, &value[0]);
     }
     void setVec3(const std::string& name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(location(name), x, y, z);
     }
     void setMat4(const std::string& name, const glm::mat4& mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // Utility function for checking shader compilation/linking errors
-    void checkCompileErrors(unsigned int shader, std::string type) {
-        int success;
-        char infoLog[1024];
-        if (type != "PROGRAM") {
-            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-            if (!success) {
-                glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
-            }
-        }
-        else {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success) {
-                glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+    struct UniformEntry {
+        std::string name;
+        GLint location;
+    };
+
+    // Active uniforms sorted by name, filled once after link
+    std::vector<UniformEntry> uniforms;
+
+    void introspectUniforms() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::vector<char> nameBuffer(static_cast<size_t>(std::max(maxLength, 1)));
+        uniforms.clear();
+        uniforms.reserve(static_cast<size_t>(count));
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &size, &type, nameBuffer.data());
+
+            std::string name(nameBuffer.data(), static_cast<size_t>(length));
+            GLint loc = glGetUniformLocation(ID, name.c_str());
+            // Members of uniform blocks have no location
+            if (loc < 0)
+                continue;
+
+            // Arrays are reported as "name[0]"; make them reachable by the bare name as well
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+                uniforms.push_back({ name.substr(0, name.size() - 3), loc });
             }
+            uniforms.push_back({ name, loc });
         }
+
+        std::sort(uniforms.begin(), uniforms.end(),
+            [](const UniformEntry& a, const UniformEntry& b) { return a.name < b.name; });
+    }
+
+    GLint location(const std::string& name) const {
+        auto it = std::lower_bound(uniforms.begin(), uniforms.end(), name,
+            [](const UniformEntry& entry, const std::string& key) { return entry.name < key; });
+        if (it == uniforms.end() || it->name != name)
+            return -1;
+        return it->location;
     }
 };
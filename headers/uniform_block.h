@@ -0,0 +1,57 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ring_buffer.h"
+#include "gl_state.h"
+
+// Fixed binding points shared by every program that declares these blocks
+enum UniformBinding : GLuint {
+    FRAME_DATA_BINDING = 0,
+    LIGHT_DATA_BINDING = 1,
+    CULL_DATA_BINDING = 3
+};
+
+// C++ mirrors of the std140 blocks in shaders/*.vert/.frag; vec3 members are padded to 16 bytes
+struct FrameData {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPos;
+    float pad0;
+};
+
+struct LightData {
+    glm::vec3 position;
+    float intensity;
+    glm::vec3 ambient;
+    float pad0;
+    glm::vec3 diffuse;
+    float pad1;
+    glm::vec3 specular;
+    float pad2;
+};
+
+static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 layout");
+static_assert(sizeof(LightData) == 64, "LightData must match the std140 layout");
+
+// Uniform buffer holding one block; update() writes the buffer only when the contents change
+template<typename T>
+class UniformBlock {
+public:
+    explicit UniformBlock(GLuint binding) : binding(binding) {}
+
+    // Sets the contents and binds the block. With a ring they are written into this frame's
+    // region and bound as a range of it, so call update() every frame the block is read
+    void update(const T& data, PersistentRingBuffer* ring = nullptr) {
+        stream.assign(&data, sizeof(T), ring);
+        bind();
+    }
+
+    void bind() const {
+        stream.bind(GL_UNIFORM_BUFFER, binding);
+    }
+
+private:
+    GLuint binding;
+    StreamBuffer stream;
+};
\ No newline at end of file
@@ -0,0 +1,71 @@
+#version 460 core
+#include "vertex_input.glsl"
+
+layout(std140, binding = 0) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+struct Joint {
+    vec4 pivot;
+    vec3 axis;
+    int parent;
+};
+
+struct RobotInstance {
+    vec4 origin;
+};
+
+layout(std430, binding = 1) readonly buffer Joints {
+    Joint joints[];
+};
+
+layout(std430, binding = 2) readonly buffer RobotInstances {
+    RobotInstance instances[];
+};
+
+// joints.length() angles per instance, in radians
+layout(std430, binding = 3) readonly buffer InstanceAngles {
+    float angles[];
+};
+
+// Robots drawn by each command: instanceList[gl_BaseInstance + gl_InstanceID]
+layout(std430, binding = 6) readonly buffer InstanceList {
+    uint instanceList[];
+};
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out uint MaterialIndex;
+
+// Rotation by angle around an axis through pivot: translate(pivot) * R * translate(-pivot)
+mat4 pivotRotation(vec3 pivot, vec3 axis, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    vec3 t = (1.0 - c) * axis;
+    mat3 r = mat3(
+        t.x * axis.x + c,          t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y,
+        t.y * axis.x - s * axis.z, t.y * axis.y + c,          t.y * axis.z + s * axis.x,
+        t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, t.z * axis.z + c);
+    return mat4(vec4(r[0], 0.0), vec4(r[1], 0.0), vec4(r[2], 0.0), vec4(pivot - r * pivot, 1.0));
+}
+
+void main() {
+    int jointCount = joints.length();
+    uint instance = instanceList[gl_BaseInstance + gl_InstanceID];
+    int angleBase = int(instance) * jointCount;
+
+    // Part i moves with joint i; walk up to the root
+    mat4 model = mat4(1.0);
+    for (int j = int(drawRecords[gl_DrawID].part); j >= 0 && j < jointCount; j = joints[j].parent) {
+        model = pivotRotation(joints[j].pivot.xyz, joints[j].axis, angles[angleBase + j]) * model;
+    }
+    model[3].xyz += instances[instance].origin.xyz;
+
+    FragPos = vec3(model * vec4(vertexPosition(), 1.0));
+    // The chain is rigid, so the upper 3x3 already is the normal matrix
+    Normal = mat3(model) * vertexNormal();
+    MaterialIndex = drawRecords[gl_DrawID].material;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
\ No newline at end of file
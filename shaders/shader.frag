@@ -3,42 +3,50 @@ out vec4 FragColor;
 
 in vec3 Normal;
 in vec3 FragPos;
+flat in uint MaterialIndex;
 
-uniform vec3 viewPos;
-
-struct Material {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-}; 
+layout(std140, binding = 0) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
-struct Light {
+layout(std140, binding = 1) uniform LightData {
     vec3 position;
+    float intensity;
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
-    float intensity;
+} light;
+
+// Material table of the model, see Material; ambient.w is the shininess
+struct Material {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
 };
 
-uniform Material material;
-uniform Light light;
+layout(std430, binding = 11) readonly buffer Materials {
+    Material materials[];
+};
 
 void main() {
+    Material material = materials[MaterialIndex];
+
     // Ambient
-    vec3 ambient = light.ambient * material.ambient * light.intensity;
+    vec3 ambient = light.ambient * material.ambient.xyz * light.intensity;
     
     // Diffuse 
     vec3 norm = normalize(Normal);
     vec3 lightDir = normalize(light.position - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * (diff * material.diffuse) * light.intensity;
+    vec3 diffuse = light.diffuse * (diff * material.diffuse.xyz) * light.intensity;
     
     // Specular
     vec3 viewDir = normalize(viewPos - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * material.specular) * light.intensity;
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.ambient.w);
+    vec3 specular = light.specular * (spec * material.specular.xyz) * light.intensity;
     
     vec3 result = ambient + diffuse + specular;
     FragColor = vec4(result, 1.0);
@@ -1,16 +1,30 @@
 #version 460 core
-layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+#include "vertex_input.glsl"
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140, binding = 0) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+// Model matrix and precomputed normal matrix of each model part, see PartTransform
+struct PartTransform {
+    mat4 model;
+    mat3 normal;
+};
+
+layout(std430, binding = 0) readonly buffer MeshTransforms {
+    PartTransform meshTransforms[];
+};
 
 out vec3 FragPos;
 out vec3 Normal;
+flat out uint MaterialIndex;
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    PartTransform part = meshTransforms[drawRecords[gl_DrawID].part];
+    FragPos = vec3(part.model * vec4(vertexPosition(), 1.0));
+    Normal = part.normal * vertexNormal();
+    MaterialIndex = drawRecords[gl_DrawID].material;
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
+}
\ No newline at end of file
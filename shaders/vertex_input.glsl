@@ -0,0 +1,55 @@
+// Shared by shaders/shader.vert and shaders/instanced.vert through #include: the draw records
+// and the vertex decode, vertexPosition()/vertexNormal(), for both vertex formats
+// Part (transform slot / joint), mesh and material of each draw within glMultiDrawElementsIndirect
+struct DrawRecord {
+    uint part;
+    uint mesh;
+    uint material;
+};
+
+layout(std430, binding = 5) readonly buffer DrawRecords {
+    DrawRecord drawRecords[];
+};
+
+#ifdef PACKED_VERTICES
+// unorm16 position inside the mesh bounds and octahedral normal, see PackedVertex
+layout(location = 0) in vec3 aPosQ;
+layout(location = 1) in vec2 aNormalOct;
+
+struct MeshDequant {
+    vec4 offset;
+    vec4 scale;
+};
+
+layout(std430, binding = 4) readonly buffer MeshDequantTable {
+    MeshDequant meshDequant[];
+};
+
+vec3 octahedralDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 vertexPosition() {
+    MeshDequant dequant = meshDequant[drawRecords[gl_DrawID].mesh];
+    return dequant.offset.xyz + aPosQ * dequant.scale.xyz;
+}
+
+vec3 vertexNormal() {
+    return octahedralDecode(aNormalOct);
+}
+#else
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+
+vec3 vertexPosition() {
+    return aPos;
+}
+
+vec3 vertexNormal() {
+    return aNormal;
+}
+#endif
\ No newline at end of file